@@ -0,0 +1,78 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <atomic>
+#include <cstddef>
+
+/*The allocation hooks replace the malloc family of glibc, which explicitly allows
+ this, and forward to its allocator under its internal names. Since they apply to
+ the whole program they are only compiled in on request, with the CMake option
+ ENABLE_ALLOCATION_COUNTER*/
+#if defined(ENABLE_ALLOCATION_COUNTER) && defined(__GLIBC__)
+#define ALLOCATION_COUNTER_HOOKS
+#endif
+
+/*! \brief Number of heap allocations of the program
+ *
+ * The counter is incremented by the allocation hooks defined in CA_4.cc for every call
+ * of malloc, calloc, realloc and the aligned allocation functions, i.e. it covers
+ * operator new as well as the aligned vectors of deal.II (posix_memalign) and the
+ * allocations within the libraries. It is shared by all threads and incremented with
+ * relaxed atomics, i.e. the count of a phase includes the allocations of the worker
+ * threads it starts. Without the hooks (the default, or other C libraries than glibc)
+ * all counts are zero.
+ */
+namespace AllocationCounter
+{
+	inline std::atomic<unsigned long long> &counter()
+	{
+		//Constant initialization, i.e. usable before the first allocation of the program
+		static std::atomic<unsigned long long> n_allocations_total(0);
+		return n_allocations_total;
+	}
+
+	inline void count_allocation()
+	{
+		counter().fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/*! Number of heap allocations since the start of the program
+	 */
+	inline unsigned long long n_allocations()
+	{
+		return counter().load(std::memory_order_relaxed);
+	}
+
+	/*! true if the allocation hooks are compiled in, i.e. the counts are meaningful
+	 */
+	inline bool enabled()
+	{
+#ifdef ALLOCATION_COUNTER_HOOKS
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	/*! \brief Adds the number of heap allocations during its lifetime to a count
+	 */
+	class Scope
+	{
+		public:
+			explicit Scope(unsigned long long &count)
+			:
+			count(count),
+			n_allocations_start(n_allocations())
+			{}
+			~Scope()
+			{
+				count += n_allocations() - n_allocations_start;
+			}
+
+		private:
+			unsigned long long &count;
+			const unsigned long long n_allocations_start;
+	};
+}
+
+#endif
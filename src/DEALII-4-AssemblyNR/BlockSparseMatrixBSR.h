@@ -0,0 +1,360 @@
+#ifndef BLOCKSPARSEMATRIXBSR_H
+#define BLOCKSPARSEMATRIXBSR_H
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/memory_consumption.h>
+#include <deal.II/base/parallel.h>
+#include <deal.II/base/subscriptor.h>
+#include <deal.II/base/tensor.h>
+#include <deal.II/base/types.h>
+#include <deal.II/base/vectorization.h>
+//The library instantiates AffineConstraints::distribute_local_to_global only for its
+//own matrix types, the generic definition is needed for this one
+#include <deal.II/lac/affine_constraints.templates.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/exceptions.h>
+#include <deal.II/lac/vector.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace dealii;
+
+/*! \brief Sparse matrix of dense block_size x block_size blocks (block compressed sparse row)
+ *
+ * For a vector valued problem with block_size components per node, and the dofs
+ * numbered node by node such that dof = node * block_size + component, all
+ * entries coupling two nodes form one dense block. Only one column index is
+ * stored per block instead of one per entry, and vmult() multiplies whole blocks
+ * with VectorizedArray, several entries of a block per SIMD instruction.
+ * The block rows are processed in parallel.
+ *
+ * The entries are filled with add(), which has the signature of SparseMatrix::add
+ * such that AffineConstraints::distribute_local_to_global can write into this
+ * matrix. precondition_SSOR() implements a block SSOR sweep with the inverted
+ * diagonal blocks, such that PreconditionSSOR can be used with this matrix.
+ */
+template <int block_size>
+class BlockSparseMatrixBSR : public Subscriptor
+{
+	public:
+		typedef double                  value_type;
+		typedef types::global_dof_index size_type;
+
+		/*! Allocate all blocks containing at least one entry of the given
+		 * sparsity pattern; the diagonal blocks are always allocated
+		 */
+		void reinit(const DynamicSparsityPattern &dsp);
+		/*! Only zero may be assigned, i.e. reset all entries
+		 */
+		BlockSparseMatrixBSR &operator=(const double d);
+		/*! Add value to the scalar entry (i,j)
+		 */
+		void add(const size_type i, const size_type j, const double value);
+		/*! Add a row of values, same signature as SparseMatrix::add
+		 */
+		void add(const size_type row,
+				const size_type n_cols,
+				const size_type *col_indices,
+				const double *vals,
+				const bool elide_zero_values = true,
+				const bool col_indices_are_sorted = false);
+		/*! dst = A * src. The entries of a block are loaded into VectorizedArrays as
+		 * stored, multiplied with the entries of src gathered into the same layout and
+		 * accumulated over the block row; the row sums are formed once per block row
+		 */
+		void vmult(Vector<double> &dst, const Vector<double> &src) const;
+		/*! Apply the block SSOR preconditioner with relaxation parameter omega.
+		 * The last argument is only there for compatibility with PreconditionSSOR
+		 */
+		void precondition_SSOR(Vector<double> &dst,
+							const Vector<double> &src,
+							const double omega = 1.,
+							const std::vector<std::size_t> &pos_right_of_diagonal = std::vector<std::size_t>()) const;
+
+		size_type m() const
+		{
+			return n_block_rows() * block_size;
+		}
+		size_type n() const
+		{
+			return m();
+		}
+		size_type n_block_rows() const
+		{
+			return row_start.empty() ? 0 : row_start.size() - 1;
+		}
+		/*! Number of stored scalar entries, including the zeros inside the blocks
+		 */
+		std::size_t n_nonzero_elements() const
+		{
+			return values.empty() ? 0 : values.size() - n_padding_entries;
+		}
+		std::size_t memory_consumption() const
+		{
+			return (MemoryConsumption::memory_consumption(row_start)
+					+ MemoryConsumption::memory_consumption(block_column_indices)
+					+ MemoryConsumption::memory_consumption(diagonal_block)
+					+ MemoryConsumption::memory_consumption(values)
+					+ MemoryConsumption::memory_consumption(inverse_diagonal_blocks));
+		}
+
+	private:
+		static const unsigned int entries_per_block = block_size * block_size;
+		/*! Number of VectorizedArrays covering the entries of one block */
+		static const unsigned int n_chunks_per_block = (entries_per_block + VectorizedArray<double>::n_array_elements - 1)
+														/ VectorizedArray<double>::n_array_elements;
+		/*! Zeros behind the last block, such that the last chunk of every block can be loaded */
+		static const unsigned int n_padding_entries = n_chunks_per_block * VectorizedArray<double>::n_array_elements
+														- entries_per_block;
+
+		/*! Compute the inverses of the diagonal blocks if the matrix changed
+		 */
+		void update_inverse_diagonal_blocks() const;
+
+		std::vector<std::size_t>  row_start;
+		std::vector<unsigned int> block_column_indices;
+		/*! Position of the diagonal block within each block row */
+		std::vector<std::size_t>  diagonal_block;
+		/*! Entries of all blocks, each block stored row-major, and n_padding_entries zeros */
+		std::vector<double>       values;
+
+		mutable std::vector<Tensor<2, block_size> > inverse_diagonal_blocks;
+		mutable bool                                inverse_diagonal_blocks_valid = false;
+};
+
+
+
+
+//Definition of the member functions
+//-----------------------------------------------------------
+//-----------------------------------------------------------
+template <int block_size>
+void BlockSparseMatrixBSR<block_size>::reinit(const DynamicSparsityPattern &dsp)
+{
+	Assert(dsp.n_rows() == dsp.n_cols(), ExcNotQuadratic());
+	Assert(dsp.n_rows() % block_size == 0,
+			ExcMessage("The number of rows has to be a multiple of the block size"));
+	const size_type n_blocks = dsp.n_rows() / block_size;
+
+	std::vector<std::vector<unsigned int> > block_columns(n_blocks);
+	for (size_type I = 0; I < n_blocks; ++I)
+	{
+		std::vector<unsigned int> &columns = block_columns[I];
+		columns.push_back(I);
+		for (unsigned int a = 0; a < block_size; ++a)
+		{
+			const size_type row = I * block_size + a;
+			for (size_type k = 0; k < dsp.row_length(row); ++k)
+				columns.push_back(dsp.column_number(row, k) / block_size);
+		}
+		std::sort(columns.begin(), columns.end());
+		columns.erase(std::unique(columns.begin(), columns.end()), columns.end());
+	}
+
+	row_start.assign(n_blocks + 1, 0);
+	for (size_type I = 0; I < n_blocks; ++I)
+		row_start[I + 1] = row_start[I] + block_columns[I].size();
+
+	block_column_indices.resize(row_start[n_blocks]);
+	diagonal_block.resize(n_blocks);
+	for (size_type I = 0; I < n_blocks; ++I)
+	{
+		std::copy(block_columns[I].begin(), block_columns[I].end(),
+				block_column_indices.begin() + row_start[I]);
+		diagonal_block[I] = row_start[I]
+							+ (std::lower_bound(block_columns[I].begin(), block_columns[I].end(), I)
+							- block_columns[I].begin());
+	}
+
+	values.assign(row_start[n_blocks] * entries_per_block + n_padding_entries, 0.);
+	inverse_diagonal_blocks_valid = false;
+}
+
+
+
+template <int block_size>
+BlockSparseMatrixBSR<block_size> &BlockSparseMatrixBSR<block_size>::operator=(const double d)
+{
+	Assert(d == 0, ExcScalarAssignmentOnlyForZeroValue());
+	(void)d;
+	std::fill(values.begin(), values.end(), 0.);
+	inverse_diagonal_blocks_valid = false;
+	return *this;
+}
+
+
+
+template <int block_size>
+void BlockSparseMatrixBSR<block_size>::add(const size_type i, const size_type j, const double value)
+{
+	const size_type I = i / block_size;
+	const size_type J = j / block_size;
+	const auto begin = block_column_indices.begin() + row_start[I];
+	const auto end = block_column_indices.begin() + row_start[I + 1];
+	const auto position = std::lower_bound(begin, end, J);
+	Assert(position != end && *position == J,
+			ExcMessage("Block does not exist in the sparsity pattern"));
+	const std::size_t block = position - block_column_indices.begin();
+	values[block * entries_per_block + (i % block_size) * block_size + (j % block_size)] += value;
+	inverse_diagonal_blocks_valid = false;
+}
+
+
+
+template <int block_size>
+void BlockSparseMatrixBSR<block_size>::add(const size_type row,
+											const size_type n_cols,
+											const size_type *col_indices,
+											const double *vals,
+											const bool elide_zero_values,
+											const bool /*col_indices_are_sorted*/)
+{
+	for (size_type k = 0; k < n_cols; ++k)
+	{
+		if (elide_zero_values && vals[k] == 0.)
+			continue;
+		add(row, col_indices[k], vals[k]);
+	}
+}
+
+
+
+template <int block_size>
+void BlockSparseMatrixBSR<block_size>::vmult(Vector<double> &dst, const Vector<double> &src) const
+{
+	Assert(&dst != &src, ExcMessage("Source and destination must not be the same vector"));
+	typedef VectorizedArray<double> VectorizedDouble;
+	const unsigned int n_lanes = VectorizedDouble::n_array_elements;
+	const double *const src_ptr = src.begin();
+	double *const dst_ptr = dst.begin();
+
+	//Entry (a,b) of a block is multiplied with entry b of the src block, i.e. the
+	//src entries are gathered with these offsets. The lanes behind the last entry
+	//of the block read entry 0 and are never summed up
+	unsigned int src_offsets[n_chunks_per_block * n_lanes];
+	for (unsigned int e = 0; e < n_chunks_per_block * n_lanes; ++e)
+		src_offsets[e] = (e < entries_per_block ? e % block_size : 0);
+
+	//Every block row writes to its own entries of dst only
+	parallel::apply_to_subranges(size_type(0), n_block_rows(),
+		[&](const size_type begin, const size_type end)
+		{
+			for (size_type I = begin; I < end; ++I)
+			{
+				//Products of all blocks of the row, entry by entry
+				VectorizedDouble products[n_chunks_per_block];
+				for (unsigned int c = 0; c < n_chunks_per_block; ++c)
+					products[c] = 0.;
+				for (std::size_t k = row_start[I]; k < row_start[I + 1]; ++k)
+				{
+					const double *const block = &values[k * entries_per_block];
+					const double *const x = src_ptr + std::size_t(block_column_indices[k]) * block_size;
+					for (unsigned int c = 0; c < n_chunks_per_block; ++c)
+					{
+						VectorizedDouble block_entries, x_entries;
+						block_entries.load(block + c * n_lanes);
+						x_entries.gather(x, src_offsets + c * n_lanes);
+						products[c] += block_entries * x_entries;
+					}
+				}
+				//Row sums of the products
+				for (unsigned int a = 0; a < block_size; ++a)
+				{
+					double result = 0.;
+					for (unsigned int b = 0; b < block_size; ++b)
+					{
+						const unsigned int e = a * block_size + b;
+						result += products[e / n_lanes][e % n_lanes];
+					}
+					dst_ptr[I * block_size + a] = result;
+				}
+			}
+		},
+		256);
+}
+
+
+
+template <int block_size>
+void BlockSparseMatrixBSR<block_size>::update_inverse_diagonal_blocks() const
+{
+	if (inverse_diagonal_blocks_valid)
+		return;
+	inverse_diagonal_blocks.resize(n_block_rows());
+	for (size_type I = 0; I < n_block_rows(); ++I)
+	{
+		Tensor<2, block_size> diagonal;
+		const double *const block = &values[diagonal_block[I] * entries_per_block];
+		for (unsigned int a = 0; a < block_size; ++a)
+			for (unsigned int b = 0; b < block_size; ++b)
+				diagonal[a][b] = block[a * block_size + b];
+		inverse_diagonal_blocks[I] = invert(diagonal);
+	}
+	inverse_diagonal_blocks_valid = true;
+}
+
+
+
+template <int block_size>
+void BlockSparseMatrixBSR<block_size>::precondition_SSOR(Vector<double> &dst,
+														const Vector<double> &src,
+														const double omega,
+														const std::vector<std::size_t> &) const
+{
+	update_inverse_diagonal_blocks();
+
+	//Multiply a block with the block_size entries starting at x, i.e. r -= B x
+	auto subtract_block_product = [](const double *block, const double *x, Tensor<1, block_size> &r)
+	{
+		for (unsigned int a = 0; a < block_size; ++a)
+			for (unsigned int b = 0; b < block_size; ++b)
+				r[a] -= block[a * block_size + b] * x[b];
+	};
+	double *const x = dst.begin();
+
+	//Forward sweep: x_I = omega D_I^-1 (src_I - sum_{J<I} B_IJ x_J)
+	for (size_type I = 0; I < n_block_rows(); ++I)
+	{
+		Tensor<1, block_size> residual;
+		for (unsigned int a = 0; a < block_size; ++a)
+			residual[a] = src(I * block_size + a);
+		for (std::size_t k = row_start[I]; k < diagonal_block[I]; ++k)
+			subtract_block_product(&values[k * entries_per_block],
+								x + std::size_t(block_column_indices[k]) * block_size,
+								residual);
+		const Tensor<1, block_size> x_I = omega * (inverse_diagonal_blocks[I] * residual);
+		for (unsigned int a = 0; a < block_size; ++a)
+			x[I * block_size + a] = x_I[a];
+	}
+
+	//Scaling with the diagonal blocks: x_I = (2-omega)/omega^2 D_I x_I
+	for (size_type I = 0; I < n_block_rows(); ++I)
+	{
+		const double *const block = &values[diagonal_block[I] * entries_per_block];
+		double scaled[block_size] = {};
+		for (unsigned int a = 0; a < block_size; ++a)
+			for (unsigned int b = 0; b < block_size; ++b)
+				scaled[a] += block[a * block_size + b] * x[I * block_size + b];
+		for (unsigned int a = 0; a < block_size; ++a)
+			x[I * block_size + a] = (2. - omega) / (omega * omega) * scaled[a];
+	}
+
+	//Backward sweep: x_I = omega D_I^-1 (x_I - sum_{J>I} B_IJ x_J)
+	for (size_type I = n_block_rows(); I-- > 0;)
+	{
+		Tensor<1, block_size> residual;
+		for (unsigned int a = 0; a < block_size; ++a)
+			residual[a] = x[I * block_size + a];
+		for (std::size_t k = diagonal_block[I] + 1; k < row_start[I + 1]; ++k)
+			subtract_block_product(&values[k * entries_per_block],
+								x + std::size_t(block_column_indices[k]) * block_size,
+								residual);
+		const Tensor<1, block_size> x_I = omega * (inverse_diagonal_blocks[I] * residual);
+		for (unsigned int a = 0; a < block_size; ++a)
+			x[I * block_size + a] = x_I[a];
+	}
+}
+//----------------------------------------------------------------------------
+
+#endif
@@ -1,11 +1,16 @@
 
+#include <deal.II/base/aligned_vector.h>
 #include <deal.II/base/function.h>
+#include <deal.II/base/memory_consumption.h>
+#include <deal.II/base/multithread_info.h>
 #include <deal.II/base/parameter_handler.h>
 #include <deal.II/base/point.h>
 #include <deal.II/base/quadrature_lib.h>
 #include <deal.II/base/symmetric_tensor.h>
 #include <deal.II/base/tensor.h>
+#include <deal.II/base/thread_local_storage.h>
 #include <deal.II/base/timer.h>
+#include <deal.II/base/vectorization.h>
 #include <deal.II/base/work_stream.h>
 
 #include <deal.II/dofs/dof_renumbering.h>
@@ -28,21 +33,93 @@
 #include <deal.II/lac/sparse_matrix.h>
 #include <deal.II/lac/vector.h>
 
+#include <deal.II/lac/diagonal_matrix.h>
 #include <deal.II/lac/full_matrix.h>
 #include <deal.II/lac/precondition.h>
 #include <deal.II/lac/solver_cg.h>
+#include <deal.II/lac/solver_gmres.h>
 #include <deal.II/lac/sparse_direct.h>
 #include <deal.II/lac/affine_constraints.h>
 
 #include <deal.II/numerics/data_out.h>
 #include <deal.II/numerics/vector_tools.h>
 
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <deque>
 #include <iostream>
 #include <fstream>
+#include <stdexcept>
 
+#include "AllocationCounter.h"
 #include "HyperCubeWithRefinedHole.h"
 #include "StrainMeasures.h"
 #include "NeoHookeanMaterial.h"
+#include "NeoHookeanOperator.h"
+#include "SymmetricSparseMatrix.h"
+#include "BlockSparseMatrixBSR.h"
+#include "PreconditionerReusePolicy.h"
+#include "SparseDirectUMFPACKCached.h"
+#include "GeometricMultigrid.h"
+#include "JacobianFreeOperator.h"
+#include "SolverDeflatedCG.h"
+#include "SolverSingleReductionCG.h"
+
+
+#ifdef ALLOCATION_COUNTER_HOOKS
+/*Heap allocation hooks of AllocationCounter: count and forward to the allocator of glibc,
+ such that free() of glibc still matches all allocations*/
+extern "C"
+{
+	void *__libc_malloc(std::size_t size);
+	void *__libc_calloc(std::size_t n_elements, std::size_t size);
+	void *__libc_realloc(void *ptr, std::size_t size);
+	void *__libc_memalign(std::size_t alignment, std::size_t size);
+
+	void *malloc(std::size_t size) noexcept
+	{
+		AllocationCounter::count_allocation();
+		return __libc_malloc(size);
+	}
+	void *calloc(std::size_t n_elements, std::size_t size) noexcept
+	{
+		AllocationCounter::count_allocation();
+		return __libc_calloc(n_elements, size);
+	}
+	void *realloc(void *ptr, std::size_t size) noexcept
+	{
+		AllocationCounter::count_allocation();
+		return __libc_realloc(ptr, size);
+	}
+	void *memalign(std::size_t alignment, std::size_t size) noexcept
+	{
+		AllocationCounter::count_allocation();
+		return __libc_memalign(alignment, size);
+	}
+	void *aligned_alloc(std::size_t alignment, std::size_t size) noexcept
+	{
+		AllocationCounter::count_allocation();
+		return __libc_memalign(alignment, size);
+	}
+	int posix_memalign(void **ptr, std::size_t alignment, std::size_t size) noexcept
+	{
+		if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+		{
+			return EINVAL;
+		}
+		AllocationCounter::count_allocation();
+		void *result = __libc_memalign(alignment, size);
+		if (result == nullptr)
+		{
+			return ENOMEM;
+		}
+		*ptr = result;
+		return 0;
+	}
+}
+#endif
 
 
 //-----------------------------------------------------------------------------------
@@ -67,9 +144,22 @@ public:
 
 	virtual ~Solid(	);
 
+	/*!Declare the runtime options read by parse_parameters() together with their defaults*/
+	static void declare_parameters(ParameterHandler &prm);
+	/*!Set the runtime options from the entries declared by declare_parameters(), e.g.
+	 * after reading an input file; called before run()*/
+	void parse_parameters(ParameterHandler &prm);
+
 	void run();
+	/*!Set up the system and time assemble_system() with the runtime-degree, the
+	 * fixed-size and the Voigt cell kernel instead of running the computation*/
+	void benchmark_cell_kernels();
 
 private:
+	/*!Newton did not converge within max_number_newton_iterations; caught by the
+	 * adaptive load stepping to cut back the load increment*/
+	DeclExceptionMsg (ExcNonlinearNoConvergence,
+					"No convergence in nonlinear solver!");
 	
 	/*!
 	 * Generate a mesh using function from namespace HyperCubeWithRefinedHole
@@ -80,16 +170,103 @@ private:
 	 * sparse matrix and all used vectors.
 	 */
 	void system_setup();
-	/*!Assemble the linear system for the elasticity problem*/
-	void assemble_system();
+	/*!Distribute and renumber the dofs and set up the hanging node constraints; the
+	 * preconditioners, the factorization and the recycled vectors of a previous
+	 * numbering are released*/
+	void setup_dofs();
+	/*!Build the sparsity pattern for the current numbering and constraints and allocate
+	 * the assembled tangent in its representation tangent_type*/
+	void setup_sparsity_pattern();
+	/*!Parts of the linear system computed by assemble_system()*/
+	enum AssemblyType
+	{
+		residual_only,
+		tangent_only,
+		residual_and_tangent
+	};
+	/*!Assemble the linear system for the elasticity problem. The loop over
+	 * all cells is distributed over several threads using WorkStream.
+	 * Only the requested parts are computed and added, i.e. system_rhs
+	 * and/or tangent_matrix have to be reset by the caller*/
+	void assemble_system(const AssemblyType assembly_type = residual_and_tangent);
+	/*!Negative residual (as system_rhs) at solution_n + solution_delta_trial, added to
+	 * residual. Neither system_rhs nor the tangent nor solution_delta are changed, only
+	 * the buffers of the residual evaluations*/
+	void assemble_residual(const Vector<double> &solution_delta_trial,
+							Vector<double> &residual);
+	/*!Set all entries of the assembled tangent to zero, whatever its storage*/
+	void reset_tangent();
 	/*!Set hanging node and Dirichlet constraints*/
 	void make_constraints(const int &it_nr);
-	/*!Newton-Raphson algorithm looping over all newton iterations*/
-	void solve_load_step_NR(Vector<double> &solution_delta);
-	/*!Solve the linear system as assemble via assemble_system()*/
-	std::pair<unsigned int, double> solve_linear_system(Vector<double> &newton_update);
+	/*!Newton-Raphson algorithm looping over all newton iterations; returns the number of
+	 * iterations and throws if Newton does not converge*/
+	unsigned int solve_load_step_NR(Vector<double> &solution_delta);
+	/*!Initial guess of solution_delta for the current load step according to predictor_type;
+	 * for the tangent predictor system_rhs has to hold the residual at solution_delta = 0*/
+	void predict_solution_delta(Vector<double> &solution_delta);
+	/*!Solve the current load step once more from solution_delta = 0 without predictor and
+	 * return the number of Newton iterations; solution_delta is restored afterwards*/
+	unsigned int count_newton_iterations_without_predictor();
+	/*!Solve the linear system with the tangent as assembled via assemble_system() and the
+	 * given rhs; an iterative solver stops at relative_tolerance times the norm of the rhs*/
+	std::pair<unsigned int, double> solve_linear_system(Vector<double> &newton_update,
+														const double relative_tolerance,
+														const Vector<double> &rhs);
+	/*!Linearise at the current Newton iterate: assemble the tangent or, for the
+	 * matrix-free operator, update its linearization point. If the tangent was already
+	 * assembled together with the residual only its bookkeeping is done*/
+	void update_tangent(const bool assembled_with_residual = false);
+	/*!Quasi-Newton direction from the L-BFGS two-loop recursion with the stored pairs
+	 * bfgs_pairs on top of the inverse of the last assembled tangent*/
+	std::pair<unsigned int, double> solve_quasi_newton(Vector<double> &newton_update,
+														const double relative_tolerance);
+	/*!Eisenstat-Walker forcing term for the next linear solve from the current and the
+	 * previous norm of the residual and the previous forcing term*/
+	double get_forcing_term(const double error_residual_previous,
+							const double forcing_term_previous) const;
+	/*!Run the given Krylov solver for matrix with the preconditioner belonging to
+	 * tangent_type and preconditioner_type*/
+	template <typename SolverType, typename MatrixType>
+	void solve_preconditioned(SolverType &solver,
+							const MatrixType &matrix,
+							Vector<double> &newton_update,
+							const Vector<double> &rhs);
+	/*!Solve with the Krylov method of solver_type and the preconditioner set up for the
+	 * current tangent, "Direct" being CG preconditioned with an older factorization. Only
+	 * if record_statistics the solve enters the recycled subspace and the counters of
+	 * "DeflatedCG", which a reference solve must not*/
+	void run_krylov_solver(SolverControl &solver_control,
+							Vector<double> &solution,
+							const Vector<double> &rhs,
+							const bool record_statistics);
+	/*!Run the given Krylov solver for the tangent in its representation tangent_type*/
+	template <typename SolverType>
+	void solve_tangent(SolverType &solver,
+						Vector<double> &newton_update,
+						const Vector<double> &rhs);
+	/*!(Re)build the preconditioner of the linear solver for the current tangent*/
+	void setup_preconditioner();
+	/*!true if the setup of the preconditioner has a cost of its own and is therefore
+	 * only repeated when preconditioner_policy asks for it: the multigrid levels, the
+	 * Chebyshev eigenvalue estimate and the numeric factorization of the direct solver*/
+	bool uses_preconditioner_policy() const;
+	/*!Assemble the tangent at the current solution on all levels of the mesh for the
+	 * multigrid preconditioner; the solution on non-active cells is interpolated from
+	 * their children*/
+	void assemble_multigrid_matrices();
 	
 	Vector<double> get_total_solution(const Vector<double> &solution_delta) const;
+	/*!Same as above, written into solution_total without allocating if it has the right size*/
+	void get_total_solution(const Vector<double> &solution_delta,
+							Vector<double> &solution_total) const;
+	/*!Total potential energy, i.e. the Neo-Hookean strain energy minus the work of the
+	 * Neumann traction, for the given solution_delta; infinite if det F <= 0 anywhere*/
+	double compute_potential_energy(const Vector<double> &solution_delta);
+	/*!Step length along newton_update found by a backtracking line search on the
+	 * potential energy; n_evaluations returns the number of energy evaluations*/
+	double line_search(const Vector<double> &solution_delta,
+						const Vector<double> &newton_update,
+						unsigned int &n_evaluations);
 
 	void output_results() const;
 
@@ -106,6 +283,7 @@ private:
 		u_dof = 0
 	};
 
+	const unsigned int               n_q_points_1d;
 	const QGauss<dim>                qf_cell;
 	const QGauss<dim - 1>            qf_face;
 	const unsigned int               n_q_points;
@@ -116,15 +294,82 @@ private:
 
 	SparsityPattern             sparsity_pattern;
 	SparseMatrix<double>        tangent_matrix;
+	/*!Upper triangle of the tangent, used instead of tangent_matrix
+	 if tangent_type == "SparseSymmetric"*/
+	SymmetricSparseMatrix       tangent_matrix_sym;
+	/*!Tangent stored in dense dim x dim nodal blocks, used instead of tangent_matrix
+	 if tangent_type == "BlockSparse"*/
+	BlockSparseMatrixBSR<dim>   tangent_matrix_bsr;
+	/*!Linearised operator applied cell by cell, used instead of tangent_matrix
+	 if tangent_type == "MatrixFree"*/
+	std::unique_ptr<NeoHookeanOperatorBase<dim> > mf_operator;
+	/*!Preconditioners kept between the linear solves. Multigrid and Chebyshev are only
+	 rebuilt when preconditioner_policy asks for it. The SSOR variants always apply the
+	 current entries of their matrix, i.e. they are set up once per numbering, and the
+	 Jacobi diagonal is recomputed for every new linearization point*/
+	PreconditionSSOR<>                            preconditioner_ssor;
+	PreconditionSSOR<SymmetricSparseMatrix>       preconditioner_ssor_sym;
+	PreconditionSSOR<BlockSparseMatrixBSR<dim> >  preconditioner_ssor_bsr;
+	std::shared_ptr<DiagonalMatrix<Vector<double> > > preconditioner_jacobi;
+	std::unique_ptr<PreconditionChebyshev<NeoHookeanOperatorBase<dim>, Vector<double> > > preconditioner_chebyshev;
+	/*!Level matrices and V-cycle if preconditioner_type == "Multigrid"*/
+	GeometricMultigrid<dim>                       multigrid;
+	PreconditionerReusePolicy                     preconditioner_policy;
+	/*!The preconditioner not governed by preconditioner_policy has been set up for the
+	 current numbering*/
+	bool                                          preconditioner_set_up = false;
+#ifdef DEAL_II_WITH_UMFPACK
+	/*!Factorization of tangent_matrix if solver_type == "Direct"; the symbolic
+	 analysis is kept from the first Newton iteration on. The numeric factorization is
+	 repeated for a new tangent only if preconditioner_policy asks for it, otherwise the
+	 factorization of an older tangent preconditions CG*/
+	SparseDirectUMFPACKCached                     direct_solver;
+	/*!direct_solver holds the factorization of the current tangent*/
+	bool                                          factorization_current = false;
+#endif
+	/*!Solutions of the previous linear solves, deflation space if solver_type == "DeflatedCG"*/
+	RecyclingSubspace                             recycling_subspace;
+	/*!Buffers of the deflation setup, kept for all solves of "DeflatedCG"*/
+	DeflationWorkspace                            deflation_workspace;
 	Vector<double>              system_rhs;
 	Vector<double>              solution_n;
 	Vector<double>				solution_delta;
+	/*!Work vectors of the Newton loop, allocated once in system_setup() instead of in
+	 every iteration: the Newton update, the total solution the assembly reads from, the
+	 residual of the linear system of the direct solver and the residual at the
+	 linearization point of JFNK*/
+	Vector<double>              newton_update;
+	Vector<double>              solution_total;
+	Vector<double>              linear_residual;
+	Vector<double>              residual_jacobian_free;
 
 	double mu;
 	double lambda;
 	double load_magnitude;
 	unsigned int load_steps;
 	unsigned int current_load_step=0;
+	/*!Fraction of load_magnitude applied in the current load step*/
+	double load_fraction=0.0;
+	/*!Fraction of load_magnitude of the last converged load step*/
+	double load_fraction_n=0.0;
+	/*!Initial guess of the load step: "None" (solution_delta = 0), "Linear" or "Quadratic"
+	 (extrapolation of the last converged increments) or "Tangent" (solve with the last
+	 assembled tangent for the increment of the external load)*/
+	std::string predictor_type = "None";
+	/*!Load increment and solution_delta of the last converged load steps, newest first*/
+	std::deque<std::pair<double, Vector<double> > > converged_increments;
+	/*!Solve every load step a second time without predictor to count the Newton
+	 iterations the predictor saved (not with adaptive_load_stepping)*/
+	bool report_predictor_savings = false;
+	/*!Adapt the load increment instead of using load_steps equal steps: grow it after fast
+	 Newton convergence, halve it and repeat the step if Newton fails or det F <= 0*/
+	bool adaptive_load_stepping = false;
+	double load_increment_min = 1e-4;
+	double load_increment_max = 0.5;
+	/*!The load increment grows if Newton needs at most this many iterations*/
+	unsigned int newton_iterations_fast = 4;
+	double load_increment_growth = 1.5;
+	double load_increment_cutback = 0.5;
 	unsigned int max_number_newton_iterations=10;
 	unsigned int multiplier_max_iterations_linear_solver=1;
 	double error_tolerance_displacement=1e-6;
@@ -132,6 +377,131 @@ private:
 	unsigned int id_Dirichlet_boundary = 5;
 	unsigned int id_Neumann_boundary = 6;	
 	unsigned int nbr_adaptive_refinements = 2;
+	/*!Representation of the tangent: "Sparse" (assembled), "SparseSymmetric"
+	 (assembled, upper triangle only), "BlockSparse" (assembled, nodal blocks)
+	 or "MatrixFree"*/
+	std::string tangent_type = "Sparse";
+	/*!Linear solver: "CG", "SingleReductionCG" (CG with one fused reduction per iteration),
+	 "DeflatedCG" (CG deflated by the solutions of the previous solves, kept across Newton
+	 iterations and load steps), "Direct" (UMFPACK, only with the "Sparse" tangent) or
+	 "JFNK" (GMRES with finite differences of the residual, the tangent only preconditions
+	 and is therefore kept for tangent_update_interval iterations also by "Newton")*/
+	std::string solver_type = "CG";
+	/*!Maximum number of vectors of the recycled subspace of "DeflatedCG"*/
+	unsigned int recycling_dimension = 8;
+	/*!Solve every system of "DeflatedCG" a second time with plain CG to count the CG
+	 iterations the recycling saved*/
+	bool report_recycling_savings = false;
+	/*!CG iterations and matrix-vector products for the deflation setup of "DeflatedCG" over
+	 the load path, and CG iterations of the reference solves without recycling*/
+	unsigned int n_lin_it_deflated = 0;
+	unsigned int n_deflation_products = 0;
+	unsigned int n_lin_it_reference = 0;
+	/*!Tolerance of CG relative to the rhs: "Fixed" (relative_tolerance_linear_solver in
+	 every Newton iteration) or "EisenstatWalker" (adapted to the nonlinear convergence)*/
+	std::string forcing_type = "Fixed";
+	double relative_tolerance_linear_solver = 1e-9;
+	/*!Upper bound of the Eisenstat-Walker forcing terms*/
+	double forcing_term_max = 0.9;
+	/*!Nonlinear solver: "Newton" (tangent in every iteration), "ModifiedNewton" (tangent kept
+	 for tangent_update_interval iterations), "BFGS" (L-BFGS updates on top of the last
+	 tangent, a new tangent once the residual grows) or "Auto" (L-BFGS while the residual
+	 contracts faster than auto_contraction_max, a new tangent otherwise; once a secant
+	 pair violates the curvature condition modified Newton steps with the plain tangent
+	 until the next one)*/
+	std::string nonlinear_solver_type = "Newton";
+	/*!Iterations a tangent is kept for by "ModifiedNewton", the modified Newton steps of
+	 "Auto" and "Newton" with the solver "JFNK", not used otherwise*/
+	unsigned int tangent_update_interval = 4;
+	/*!Number of L-BFGS pairs kept*/
+	unsigned int bfgs_memory = 5;
+	double auto_contraction_max = 0.3;
+	/*!Number of tangent assemblies within the current load step*/
+	unsigned int n_tangent_assemblies = 0;
+	/*!True if the tangent changed since the last decision about the preconditioner or
+	 the factorization of the direct solver*/
+	bool tangent_changed = true;
+	/*!True if the assembled tangent belongs to an iterate of a discarded load step
+	 attempt, i.e. it must not be reused by the tangent predictor*/
+	bool tangent_discarded = false;
+	/*!Pair of L-BFGS: update s, change of the gradient y, 1/(y*s) and the coefficient
+	 alpha of the first loop of the two-loop recursion*/
+	struct BFGSPair
+	{
+		Vector<double> s;
+		Vector<double> y;
+		double rho;
+		double alpha;
+	};
+	/*!Storage of bfgs_memory + 1 L-BFGS pairs, allocated in system_setup(); the first
+	 n_bfgs_pairs are the pairs since the last tangent assembly, newest first, the next
+	 one takes the candidate pair*/
+	std::vector<BFGSPair> bfgs_pairs;
+	unsigned int n_bfgs_pairs = 0;
+	/*!Update and rhs of the previous Newton iteration for the L-BFGS pairs and the rhs
+	 of the two-loop recursion*/
+	Vector<double> update_previous;
+	Vector<double> rhs_previous;
+	Vector<double> quasi_newton_rhs;
+	/*!Line search along the Newton update: "None" (full steps) or "Energy" (backtracking
+	 on the potential energy)*/
+	std::string line_search_type = "None";
+	/*!Maximum number of energy evaluations of one line search*/
+	unsigned int max_line_search_evaluations = 6;
+	/*!Solve every linear system with a forcing term above relative_tolerance_linear_solver
+	 a second time to relative_tolerance_linear_solver to count the iterations it saved*/
+	bool report_forcing_savings = false;
+	/*!Linear solver iterations the forcing terms saved within the current load step*/
+	unsigned int n_lin_it_saved = 0;
+	/*!Preconditioner for CG: "SSOR" (Sparse, SparseSymmetric, BlockSparse), "Multigrid" (Sparse),
+	 "Jacobi" or "Chebyshev" (both MatrixFree)*/
+	std::string preconditioner_type = "SSOR";
+	/*!Polynomial degree of the Chebyshev preconditioner*/
+	unsigned int chebyshev_degree = 4;
+	/*!Maximum number of threads used for the assembly (0: use all available cores)*/
+	unsigned int number_threads = 0;
+	/*!Numbering of the dofs: "None", "CuthillMcKee", "ReverseCuthillMcKee", "King",
+	 "MinimumDegree", "ComponentWise", "BlockWise", "Hierarchical" (DoFRenumbering::hierarchical,
+	 i.e. a Z-order within every coarse cell, the coarse cells keep their order),
+	 "SpaceFillingCurve" (the cells along a Z-order curve through their centers over the
+	 whole mesh) or "Random"*/
+	std::string renumbering_type = "CuthillMcKee";
+	/*!Set up the system with every renumbering before the first load step and print the
+	 bandwidth, profile, SpMV and assembly time of each (only with the "Sparse" tangent)*/
+	bool report_renumbering = false;
+	/*!Evaluate the cell quadrature of assemble_system() for VectorizedArray<double>::n_array_elements
+	 cells at once, one cell per SIMD lane*/
+	bool vectorized_assembly = false;
+	/*!Cell quadrature of the scalar assembly: "Runtime" (loops over the runtime
+	 dofs_per_cell), "FixedSize" (instantiated for the polynomial degrees 1 to 4 with
+	 loop bounds and strides of compile-time size, otherwise "Runtime" is used) or
+	 "Voigt" (B- and G-matrix in Voigt notation, the cell matrix by matrix-matrix
+	 products)*/
+	std::string kernel_type = "FixedSize";
+	/*!Time the assembly for an increasing number of threads before the first load step*/
+	bool report_assembly_scaling = false;
+	/*!Compare NeoHookeanMaterial::evaluate with the separate getters before the first load step*/
+	bool report_material_benchmark = false;
+	/*!Print the heap allocations of the phases of the Newton loop after every load step*/
+	bool report_allocations = false;
+	/*!Add the Neumann traction as the external_load_unit scaled with the current load
+	 instead of integrating the faces of the Neumann boundary in every assembly*/
+	bool precompute_external_load = true;
+	/*!Phases of the Newton loop whose heap allocations are counted*/
+	enum AllocationPhase
+	{
+		allocations_constraints,
+		allocations_assembly,
+		allocations_residual_norm,
+		allocations_linear_solver,
+		allocations_update,
+		n_allocation_phases
+	};
+	/*!Heap allocations of every phase within the first Newton iteration of the current
+	 load step (including the predictor) and within all further iterations; only
+	 counted if the program is built with ENABLE_ALLOCATION_COUNTER*/
+	std::array<unsigned long long, n_allocation_phases> n_allocations_first_iteration;
+	std::array<unsigned long long, n_allocation_phases> n_allocations_further_iterations;
 	//-------------------------------------------------------------------------
 	/*!A struct used to keep track of data needed as convergence criteria. As typical for a struct all member functions and variables are public
 	 */
@@ -172,7 +542,337 @@ private:
 	/*!Output to the console
 	 */
 	void print_conv_footer();
-	//-------------------------------------------------------------------------				
+	//-------------------------------------------------------------------------
+	/*!Data each task of the WorkStream writes to and the copier reads from, i.e. the
+	 * local contributions of one cell and the global indices of its dofs
+	 */
+	struct PerTaskData_ASM
+	{
+		PerTaskData_ASM(const unsigned int dofs_per_cell,
+						const bool assemble_rhs,
+						const bool assemble_matrix)
+		:
+		cell_matrix(dofs_per_cell, dofs_per_cell),
+		cell_rhs(dofs_per_cell),
+		local_dof_indices(dofs_per_cell),
+		assemble_rhs(assemble_rhs),
+		assemble_matrix(assemble_matrix)
+		{}
+
+		void reset()
+		{
+			cell_matrix = 0.0;
+			cell_rhs = 0.0;
+			invalid_deformation = false;
+		}
+		//member variables
+		FullMatrix<double>                   cell_matrix;
+		Vector<double>                       cell_rhs;
+		std::vector<types::global_dof_index> local_dof_indices;
+		/*!Which of the local contributions are computed and copied*/
+		bool                                 assemble_rhs;
+		bool                                 assemble_matrix;
+		/*!det F <= 0 at a quadrature point of the cell. An exception thrown by a worker
+		 aborts the program within WorkStream, i.e. the worker only records it here and
+		 the caller of WorkStream::run throws once all cells are done*/
+		bool                                 invalid_deformation = false;
+	};
+	/*!Scratch objects every thread owns a copy of, such that the FEFaceValues object and
+	 * the gradient buffers are not shared between threads. The copy constructor is
+	 * required by WorkStream since FEFaceValues itself can not be copied. The cell
+	 * quantities are taken from reference_geometry instead of an FEValues object
+	 */
+	struct ScratchData_ASM
+	{
+		ScratchData_ASM(const FiniteElement<dim> &fe_cell,
+						const QGauss<dim - 1> &qf_face,
+						const UpdateFlags uf_face,
+						const Vector<double> &solution_total)
+		:
+		fe_face_values_ref(fe_cell, qf_face, uf_face),
+		local_solution(fe_cell.dofs_per_cell),
+		shape_gradients_spt(fe_cell.dofs_per_cell),
+		sym_shape_gradients_spt(fe_cell.dofs_per_cell),
+		element_matrix_M(n_voigt_rows, fe_cell.dofs_per_cell),
+		weighted_element_matrix_M(n_voigt_rows, fe_cell.dofs_per_cell),
+		weight_matrix(n_voigt_rows, n_voigt_rows),
+		solution_total(solution_total)
+		{}
+
+		ScratchData_ASM(const ScratchData_ASM &rhs)
+		:
+		fe_face_values_ref(rhs.fe_face_values_ref.get_fe(),
+						rhs.fe_face_values_ref.get_quadrature(),
+						rhs.fe_face_values_ref.get_update_flags()),
+		local_solution(rhs.local_solution),
+		shape_gradients_spt(rhs.shape_gradients_spt),
+		sym_shape_gradients_spt(rhs.sym_shape_gradients_spt),
+		material_point(rhs.material_point),
+		element_matrix_M(rhs.element_matrix_M),
+		weighted_element_matrix_M(rhs.weighted_element_matrix_M),
+		weight_matrix(rhs.weight_matrix),
+		solution_total(rhs.solution_total)
+		{}
+		//member variables
+		FEFaceValues<dim>                    fe_face_values_ref;
+		std::vector<double>                  local_solution;
+		std::vector<Tensor<2,dim> >          shape_gradients_spt;
+		std::vector<SymmetricTensor<2,dim> > sym_shape_gradients_spt;
+		typename NeoHookeanMaterial<dim>::Evaluation material_point;
+		/*!Rows of the Voigt kernel: the strains in Voigt notation and the dim x dim
+		 * spatial gradients*/
+		static const unsigned int            n_voigt_rows = SymmetricTensor<2,dim>::n_independent_components
+															+ dim * dim;
+		/*!M = [B; G], diag(D, Sigma) * JxW and their product, see assemble_cell_quadrature_voigt*/
+		FullMatrix<double>                   element_matrix_M;
+		FullMatrix<double>                   weighted_element_matrix_M;
+		FullMatrix<double>                   weight_matrix;
+		const Vector<double>                 &solution_total;
+	};
+	//-------------------------------------------------------------------------
+	/*!Shape function gradients and JxW values with respect to the reference configuration
+	 * at all cell quadrature points. The mesh never changes, i.e. they are computed once
+	 * in system_setup() and read by every assembly. The gradients are stored per
+	 * (active cell index, quadrature point, shape function) in one contiguous array.
+	 * Since every shape function of the FESystem is nonzero in one component only, just
+	 * the gradient of this component is kept
+	 */
+	struct ReferenceGeometry
+	{
+		void reinit(const unsigned int n_cells,
+					const unsigned int n_q_points,
+					const unsigned int dofs_per_cell)
+		{
+			this->n_q_points = n_q_points;
+			this->dofs_per_cell = dofs_per_cell;
+			shape_component.resize(dofs_per_cell);
+			shape_gradients.resize(std::size_t(n_cells) * n_q_points * dofs_per_cell);
+			JxW_values.resize(std::size_t(n_cells) * n_q_points);
+		}
+		/*!Pointer to the gradients of all shape functions at quadrature point q*/
+		const Tensor<1,dim> *shape_gradients_at(const unsigned int cell_index,
+												const unsigned int q) const
+		{
+			return &shape_gradients[(std::size_t(cell_index) * n_q_points + q) * dofs_per_cell];
+		}
+		Tensor<1,dim> *shape_gradients_at(const unsigned int cell_index,
+										const unsigned int q)
+		{
+			return &shape_gradients[(std::size_t(cell_index) * n_q_points + q) * dofs_per_cell];
+		}
+		double &JxW(const unsigned int cell_index, const unsigned int q)
+		{
+			return JxW_values[std::size_t(cell_index) * n_q_points + q];
+		}
+		double JxW(const unsigned int cell_index, const unsigned int q) const
+		{
+			return JxW_values[std::size_t(cell_index) * n_q_points + q];
+		}
+		std::size_t memory_consumption() const
+		{
+			return (MemoryConsumption::memory_consumption(shape_component)
+					+ MemoryConsumption::memory_consumption(shape_gradients)
+					+ MemoryConsumption::memory_consumption(JxW_values));
+		}
+		//member variables
+		unsigned int n_q_points = 0;
+		unsigned int dofs_per_cell = 0;
+		/*!The only nonzero component of each shape function*/
+		std::vector<unsigned int>  shape_component;
+		std::vector<Tensor<1,dim> > shape_gradients;
+		std::vector<double>        JxW_values;
+	};
+	ReferenceGeometry reference_geometry;
+	/*!Fill reference_geometry for all active cells and print its memory footprint*/
+	void setup_reference_geometry();
+	//-------------------------------------------------------------------------
+	/*!Face of an active cell given by the cell and its local face number*/
+	typedef std::pair<typename DoFHandler<dim>::active_cell_iterator, unsigned int> BoundaryFace;
+	/*!Faces on the Neumann boundary, collected with the external load*/
+	std::vector<BoundaryFace> neumann_faces;
+	/*!External force vector of the Neumann traction for load_magnitude * load_fraction = 1,
+	 * integrated without constraints. The traction is a dead load along the reference
+	 * normal, i.e. the external force of every load step is this vector scaled with the
+	 * current load, and system_rhs = F_ext - F_int also gives the internal force vector*/
+	Vector<double> external_load_unit_reference;
+	/*!external_load_unit_reference condensed with the current constraints, as the
+	 * local contributions of the assembly would be distributed*/
+	Vector<double> external_load_unit;
+	/*!Collect neumann_faces and integrate external_load_unit_reference over them; called
+	 * after setup_dofs(), i.e. with the hanging node constraints of the current numbering*/
+	void setup_external_load();
+	/*!Condense external_load_unit_reference into external_load_unit with the current constraints*/
+	void condense_external_load();
+	//-------------------------------------------------------------------------
+	/*!Consecutive active cells assembled together by the vectorized assembly*/
+	typedef std::vector<typename DoFHandler<dim>::active_cell_iterator> CellBatch;
+	/*!The active cells in batches of VectorizedArray<double>::n_array_elements, only the
+	 * last batch may be smaller; set up with reference_geometry*/
+	std::vector<CellBatch> cell_batches;
+	/*!Data each task of the vectorized WorkStream writes to: the local contributions
+	 * of the cells of one batch, one PerTaskData_ASM per lane*/
+	struct PerTaskData_Batch
+	{
+		PerTaskData_Batch(const unsigned int dofs_per_cell,
+						const bool assemble_rhs,
+						const bool assemble_matrix)
+		:
+		cells(VectorizedArray<double>::n_array_elements,
+			PerTaskData_ASM(dofs_per_cell, assemble_rhs, assemble_matrix)),
+		n_cells(0)
+		{}
+		//member variables
+		std::vector<PerTaskData_ASM> cells;
+		/*!Number of lanes holding a cell*/
+		unsigned int                 n_cells;
+	};
+	/*!Scratch objects of the vectorized assembly: the scalar ones for the Neumann faces,
+	 * which are assembled cell by cell, and the lane-wise buffers of the cell quadrature.
+	 * AlignedVector keeps the VectorizedArrays aligned for the SIMD loads*/
+	struct ScratchData_Batch
+	{
+		ScratchData_Batch(const FiniteElement<dim> &fe_cell,
+						const QGauss<dim - 1> &qf_face,
+						const UpdateFlags uf_face,
+						const Vector<double> &solution_total)
+		:
+		cell(fe_cell, qf_face, uf_face, solution_total),
+		local_solution(fe_cell.dofs_per_cell),
+		shape_gradients_ref(fe_cell.dofs_per_cell),
+		shape_gradients_spt(fe_cell.dofs_per_cell),
+		sym_shape_gradients_spt(fe_cell.dofs_per_cell),
+		cell_matrix(fe_cell.dofs_per_cell * fe_cell.dofs_per_cell),
+		cell_rhs(fe_cell.dofs_per_cell)
+		{}
+		//member variables
+		ScratchData_ASM                                              cell;
+		AlignedVector<VectorizedArray<double> >                      local_solution;
+		AlignedVector<Tensor<1,dim,VectorizedArray<double> > >       shape_gradients_ref;
+		AlignedVector<Tensor<2,dim,VectorizedArray<double> > >       shape_gradients_spt;
+		AlignedVector<SymmetricTensor<2,dim,VectorizedArray<double> > > sym_shape_gradients_spt;
+		/*!Upper triangle of the cell matrices, row by row with dofs_per_cell columns*/
+		AlignedVector<VectorizedArray<double> >                      cell_matrix;
+		AlignedVector<VectorizedArray<double> >                      cell_rhs;
+	};
+	/*!Scratch objects of assemble_system() kept for the whole computation, one per
+	 * thread, created at its first use from the exemplar set up in system_setup(). The
+	 * WorkStreams get the empty PooledScratchData and take their scratch from the pool,
+	 * instead of copying a new one (with its FEFaceValues) for every thread in every
+	 * assembly*/
+	struct PooledScratchData
+	{};
+	std::unique_ptr<Threads::ThreadLocalStorage<ScratchData_ASM> >   scratch_pool;
+	std::unique_ptr<Threads::ThreadLocalStorage<ScratchData_Batch> > scratch_pool_batch;
+	/*!Exemplars of the per-task data of assemble_system(), only their flags are set
+	 * for every assembly*/
+	PerTaskData_ASM                                                  per_task_data;
+	PerTaskData_Batch                                                per_task_data_batch;
+	/*!Buffers of the cell loops outside of assemble_system(), allocated in system_setup()
+	 * instead of in every call: the trial increment of the line search, the total
+	 * solution at a trial increment, read by the scratch object of the serial loops
+	 * (energy, multigrid levels) and by the scratch pool of assemble_residual(), and the
+	 * per-task data of both*/
+	Vector<double>                                                   solution_delta_trial;
+	Vector<double>                                                   solution_total_trial;
+	std::unique_ptr<ScratchData_ASM>                                 scratch_serial;
+	PerTaskData_ASM                                                  per_task_data_serial;
+	std::unique_ptr<Threads::ThreadLocalStorage<ScratchData_ASM> >   scratch_pool_residual;
+	PerTaskData_ASM                                                  per_task_data_residual;
+	/*!Gradients and JxW values of a cell of the multigrid levels, which is not part of
+	 * reference_geometry, in the layout of reference_geometry*/
+	struct ScratchData_Level
+	{
+		ScratchData_Level(const FiniteElement<dim> &fe_cell,
+						const Quadrature<dim> &qf_cell)
+		:
+		fe_values_ref(fe_cell, qf_cell, update_gradients | update_JxW_values),
+		shape_gradients_ref(qf_cell.size() * fe_cell.dofs_per_cell),
+		JxW_values(qf_cell.size()),
+		local_solution(fe_cell.dofs_per_cell)
+		{}
+		//member variables
+		FEValues<dim>                        fe_values_ref;
+		std::vector<Tensor<1,dim> >          shape_gradients_ref;
+		std::vector<double>                  JxW_values;
+		Vector<double>                       local_solution;
+	};
+	std::unique_ptr<ScratchData_Level>                               scratch_level;
+	/*!Compute the local matrices and rhs of the cells of a batch, the cell quadrature
+	 * with one cell per SIMD lane (worker of the vectorized WorkStream)*/
+	void assemble_system_cell_batch(const CellBatch &cells,
+									ScratchData_Batch &scratch,
+									PerTaskData_Batch &data) const;
+	/*!Add the Neumann traction on the faces of the cell to the local rhs*/
+	void assemble_neumann_faces(const typename DoFHandler<dim>::active_cell_iterator &cell,
+								ScratchData_ASM &scratch,
+								PerTaskData_ASM &data) const;
+	/*!Renumber the dofs according to renumbering_type*/
+	void renumber_dofs();
+	/*!Renumber the dofs node by node, i.e. dof = node*dim + component, keeping the
+	 * order of the nodes given by the current numbering; needed for the nodal
+	 * blocks of tangent_matrix_bsr*/
+	void renumber_dofs_nodewise();
+	/*!Compute the local matrix and rhs of a single cell (worker of the WorkStream)*/
+	void assemble_system_one_cell(const typename DoFHandler<dim>::active_cell_iterator &cell,
+								ScratchData_ASM &scratch,
+								PerTaskData_ASM &data) const;
+	/*!Add the contributions of all cell quadrature points to the local matrix and rhs for
+	 * the local solution in scratch. The reference gradients of the shape functions at
+	 * quadrature point k start at cell_shape_gradients_ref[k*dofs_per_cell], stored as in
+	 * reference_geometry*/
+	void assemble_cell_quadrature(const Tensor<1,dim> *cell_shape_gradients_ref,
+								const double *JxW_values,
+								ScratchData_ASM &scratch,
+								PerTaskData_ASM &data) const;
+	/*!Same as assemble_cell_quadrature for the polynomial degree fe_degree, with the
+	 * number of dofs and quadrature points known at compile time such that the
+	 * gradient buffers are fixed-size stack arrays, the cell matrix is addressed with
+	 * a compile-time row stride and the loops can be unrolled and vectorized by the
+	 * compiler*/
+	template <int fe_degree>
+	void assemble_cell_quadrature_fixed(const Tensor<1,dim> *cell_shape_gradients_ref,
+										const double *JxW_values,
+										ScratchData_ASM &scratch,
+										PerTaskData_ASM &data) const;
+	/*!Same as assemble_cell_quadrature with the element matrices in Voigt notation: per
+	 * quadrature point the strain-displacement matrix B and the matrix G of the spatial
+	 * gradients are stacked into M = [B; G] and the cell matrix is
+	 * K += M^T diag(D, Sigma) M JxW with the tangent D from get_Tangent_spt in Voigt form
+	 * and the Kirchhoff stress Sigma repeated per component, computed by FullMatrix
+	 * products, i.e. BLAS-3 if deal.II uses LAPACK*/
+	void assemble_cell_quadrature_voigt(const Tensor<1,dim> *cell_shape_gradients_ref,
+										const double *JxW_values,
+										ScratchData_ASM &scratch,
+										PerTaskData_ASM &data) const;
+	typedef void (Solid<dim>::*CellQuadratureKernel)(const Tensor<1,dim> *,
+													const double *,
+													ScratchData_ASM &,
+													PerTaskData_ASM &) const;
+	/*!Cell quadrature used by assemble_system_one_cell, chosen according to kernel_type
+	 * and the polynomial degree by select_cell_quadrature_kernel()*/
+	CellQuadratureKernel cell_quadrature_kernel = &Solid<dim>::assemble_cell_quadrature;
+	void select_cell_quadrature_kernel();
+	/*!Copy the local contributions into the global system (copier of the WorkStream).
+	 * The copier is never run concurrently, so no synchronisation is needed*/
+	void copy_local_to_global_ASM(const PerTaskData_ASM &data);
+	/*!Distribute the local contributions into the given matrix format and system_rhs*/
+	template <typename MatrixType>
+	void copy_local_to_global_ASM(const PerTaskData_ASM &data, MatrixType &matrix);
+	/*!Assemble the system with 1,2,4,... threads up to the number of cores and print
+	 * the wall time, speedup and parallel efficiency of each run
+	 */
+	void print_assembly_scaling();
+	/*!Time the fused NeoHookeanMaterial::evaluate against the separate calls of
+	 * get_KirchhoffStress, get_Tangent_spt and invert for a set of deformation
+	 * gradients and print the timings and the largest deviation of the results
+	 */
+	void print_material_benchmark();
+	/*!Renumber the dofs with every renumbering_type, assemble the system and print the
+	 * bandwidth and profile of the sparsity pattern and the wall time of a matrix-vector
+	 * product and of an assembly. Only the numbering dependent parts of system_setup()
+	 * are repeated, and restored for renumbering_type afterwards
+	 */
+	void print_renumbering_comparison();
 };
 
 
@@ -187,14 +887,19 @@ fe(FE_Q<dim>(degree), dim), // displacement
 dof_handler_ref(triangulation),
 dofs_per_cell (fe.dofs_per_cell),
 u_fe(0),
-qf_cell(2),
-qf_face(2),
+n_q_points_1d(2),
+qf_cell(n_q_points_1d),
+qf_face(n_q_points_1d),
 n_q_points (qf_cell.size()),
 n_q_points_f (qf_face.size()),
 mu(mu),
 lambda(lambda),
 load_magnitude(load_magnitude),
-load_steps(load_steps)
+load_steps(load_steps),
+per_task_data(dofs_per_cell, true, true),
+per_task_data_batch(dofs_per_cell, true, true),
+per_task_data_serial(dofs_per_cell, false, true),
+per_task_data_residual(dofs_per_cell, true, false)
 {
 }
 
@@ -206,26 +911,317 @@ Solid<dim>::~Solid()
 }
 
 
+template <int dim>
+void Solid<dim>::declare_parameters(ParameterHandler &prm)
+{
+	prm.enter_subsection("Problem");
+	{
+		prm.declare_entry("Load steps", "10", Patterns::Integer(1),
+						"Number of equal load steps, the initial ones with adaptive load stepping");
+		prm.declare_entry("Polynomial degree", "1", Patterns::Integer(1),
+						"Degree of the FE_Q displacement");
+		prm.declare_entry("Load magnitude", "-7e3", Patterns::Double(),
+						"Traction on the Neumann boundary at the end of the load path");
+		prm.declare_entry("Shear modulus", "70000", Patterns::Double(0.),
+						"Lame parameter mu of the Neo-Hookean material");
+		prm.declare_entry("Lambda", "105000", Patterns::Double(0.),
+						"Lame parameter lambda of the Neo-Hookean material");
+		prm.declare_entry("Number of adaptive refinements", "2", Patterns::Integer(0),
+						"Refinements of the mesh around the hole");
+	}
+	prm.leave_subsection();
+
+	prm.enter_subsection("Load stepping");
+	{
+		prm.declare_entry("Adaptive load stepping", "false", Patterns::Bool(),
+						"Grow the load increment after fast Newton convergence, cut it back after a failure");
+		prm.declare_entry("Minimum load increment", "1e-4", Patterns::Double(0.));
+		prm.declare_entry("Maximum load increment", "0.5", Patterns::Double(0.));
+		prm.declare_entry("Fast Newton iterations", "4", Patterns::Integer(0),
+						"The load increment grows if Newton needs at most this many iterations");
+		prm.declare_entry("Load increment growth", "1.5", Patterns::Double(1.));
+		prm.declare_entry("Load increment cutback", "0.5", Patterns::Double(0., 1.));
+		prm.declare_entry("Predictor", "None", Patterns::Selection("None|Linear|Quadratic|Tangent"),
+						"Initial guess of the load step");
+		prm.declare_entry("Report predictor savings", "false", Patterns::Bool(),
+						"Solve every load step again without predictor and print the saved Newton iterations");
+	}
+	prm.leave_subsection();
+
+	prm.enter_subsection("Nonlinear solver");
+	{
+		prm.declare_entry("Nonlinear solver", "Newton", Patterns::Selection("Newton|ModifiedNewton|BFGS|Auto"));
+		prm.declare_entry("Max Newton iterations", "10", Patterns::Integer(1));
+		prm.declare_entry("Tolerance residual", "1e-6", Patterns::Double(0.),
+						"Newton converged once the residual dropped by this factor");
+		prm.declare_entry("Tangent update interval", "4", Patterns::Integer(1),
+						"Iterations a tangent is kept for by ModifiedNewton, the modified Newton steps of Auto and Newton with JFNK");
+		prm.declare_entry("BFGS memory", "5", Patterns::Integer(0),
+						"Number of L-BFGS pairs kept");
+		prm.declare_entry("Auto contraction max", "0.3", Patterns::Double(0.),
+						"Auto assembles the tangent if the residual contracts slower than this");
+		prm.declare_entry("Line search", "None", Patterns::Selection("None|Energy"));
+		prm.declare_entry("Max line search evaluations", "6", Patterns::Integer(1));
+		prm.declare_entry("Forcing", "Fixed", Patterns::Selection("Fixed|EisenstatWalker"),
+						"Tolerance of the linear solver relative to its rhs");
+		prm.declare_entry("Forcing term max", "0.9", Patterns::Double(0., 1.));
+		prm.declare_entry("Report forcing savings", "false", Patterns::Bool(),
+						"Solve every system again to the relative tolerance of the linear solver and print the saved iterations");
+	}
+	prm.leave_subsection();
+
+	prm.enter_subsection("Linear solver");
+	{
+		prm.declare_entry("Solver", "CG", Patterns::Selection("CG|SingleReductionCG|DeflatedCG|Direct|JFNK"));
+		prm.declare_entry("Relative tolerance", "1e-9", Patterns::Double(0.));
+		prm.declare_entry("Max iterations multiplier", "1", Patterns::Integer(1),
+						"Maximum number of iterations as a multiple of the number of dofs");
+		prm.declare_entry("Preconditioner", "SSOR", Patterns::Selection("SSOR|Multigrid|Jacobi|Chebyshev"));
+		prm.declare_entry("Chebyshev degree", "4", Patterns::Integer(1));
+		prm.declare_entry("Reuse max iterations", "50", Patterns::Integer(0),
+						"Rebuild the preconditioner after a solve with more iterations");
+		prm.declare_entry("Reuse max rate deterioration", "2", Patterns::Double(1.),
+						"Rebuild the preconditioner if the residual reduction per iteration drops by this factor");
+		prm.declare_entry("Rebuild each load step", "true", Patterns::Bool());
+		prm.declare_entry("Recycling dimension", "8", Patterns::Integer(1),
+						"Maximum number of vectors of the recycled subspace of DeflatedCG");
+		prm.declare_entry("Report recycling savings", "false", Patterns::Bool(),
+						"Solve every system of DeflatedCG again with plain CG and print the saved iterations");
+	}
+	prm.leave_subsection();
+
+	prm.enter_subsection("Assembly");
+	{
+		prm.declare_entry("Number of threads", "0", Patterns::Integer(0),
+						"Maximum number of threads used for the assembly (0: all available cores)");
+		prm.declare_entry("Tangent", "Sparse", Patterns::Selection("Sparse|SparseSymmetric|BlockSparse|MatrixFree"),
+						"Representation of the tangent");
+		prm.declare_entry("Kernel", "FixedSize", Patterns::Selection("Runtime|FixedSize|Voigt"),
+						"Cell quadrature of the scalar assembly");
+		prm.declare_entry("Vectorized assembly", "false", Patterns::Bool(),
+						"One cell per SIMD lane in the cell quadrature");
+		prm.declare_entry("Precompute external load", "true", Patterns::Bool(),
+						"Add the Neumann traction as a precomputed vector instead of integrating the faces");
+		prm.declare_entry("Renumbering", "CuthillMcKee",
+						Patterns::Selection("None|CuthillMcKee|ReverseCuthillMcKee|King|MinimumDegree|"
+											"ComponentWise|BlockWise|Hierarchical|SpaceFillingCurve|Random"));
+		prm.declare_entry("Report renumbering", "false", Patterns::Bool(),
+						"Compare all renumberings before the first load step");
+		prm.declare_entry("Benchmark cell kernels", "false", Patterns::Bool(),
+						"Time the Runtime, FixedSize and Voigt kernels for the degrees 1 to 4 instead of running the computation");
+		prm.declare_entry("Report assembly scaling", "false", Patterns::Bool(),
+						"Time the assembly for an increasing number of threads before the first load step");
+		prm.declare_entry("Report material benchmark", "false", Patterns::Bool(),
+						"Time the fused material evaluation against the separate getters before the first load step");
+		prm.declare_entry("Report allocations", "false", Patterns::Bool(),
+						"Print the heap allocations of the phases of the Newton loop after every load step");
+	}
+	prm.leave_subsection();
+}
+
+
+template <int dim>
+void Solid<dim>::parse_parameters(ParameterHandler &prm)
+{
+	prm.enter_subsection("Problem");
+	{
+		nbr_adaptive_refinements = prm.get_integer("Number of adaptive refinements");
+	}
+	prm.leave_subsection();
+
+	prm.enter_subsection("Load stepping");
+	{
+		adaptive_load_stepping = prm.get_bool("Adaptive load stepping");
+		load_increment_min = prm.get_double("Minimum load increment");
+		load_increment_max = prm.get_double("Maximum load increment");
+		newton_iterations_fast = prm.get_integer("Fast Newton iterations");
+		load_increment_growth = prm.get_double("Load increment growth");
+		load_increment_cutback = prm.get_double("Load increment cutback");
+		predictor_type = prm.get("Predictor");
+		report_predictor_savings = prm.get_bool("Report predictor savings");
+	}
+	prm.leave_subsection();
+
+	prm.enter_subsection("Nonlinear solver");
+	{
+		nonlinear_solver_type = prm.get("Nonlinear solver");
+		max_number_newton_iterations = prm.get_integer("Max Newton iterations");
+		error_tolerance_residual = prm.get_double("Tolerance residual");
+		tangent_update_interval = prm.get_integer("Tangent update interval");
+		bfgs_memory = prm.get_integer("BFGS memory");
+		auto_contraction_max = prm.get_double("Auto contraction max");
+		line_search_type = prm.get("Line search");
+		max_line_search_evaluations = prm.get_integer("Max line search evaluations");
+		forcing_type = prm.get("Forcing");
+		forcing_term_max = prm.get_double("Forcing term max");
+		report_forcing_savings = prm.get_bool("Report forcing savings");
+	}
+	prm.leave_subsection();
+
+	prm.enter_subsection("Linear solver");
+	{
+		solver_type = prm.get("Solver");
+		relative_tolerance_linear_solver = prm.get_double("Relative tolerance");
+		multiplier_max_iterations_linear_solver = prm.get_integer("Max iterations multiplier");
+		preconditioner_type = prm.get("Preconditioner");
+		chebyshev_degree = prm.get_integer("Chebyshev degree");
+		preconditioner_policy.max_iterations = prm.get_integer("Reuse max iterations");
+		preconditioner_policy.max_rate_deterioration = prm.get_double("Reuse max rate deterioration");
+		preconditioner_policy.rebuild_each_load_step = prm.get_bool("Rebuild each load step");
+		recycling_dimension = prm.get_integer("Recycling dimension");
+		report_recycling_savings = prm.get_bool("Report recycling savings");
+	}
+	prm.leave_subsection();
+
+	prm.enter_subsection("Assembly");
+	{
+		number_threads = prm.get_integer("Number of threads");
+		tangent_type = prm.get("Tangent");
+		kernel_type = prm.get("Kernel");
+		vectorized_assembly = prm.get_bool("Vectorized assembly");
+		precompute_external_load = prm.get_bool("Precompute external load");
+		renumbering_type = prm.get("Renumbering");
+		report_renumbering = prm.get_bool("Report renumbering");
+		report_assembly_scaling = prm.get_bool("Report assembly scaling");
+		report_material_benchmark = prm.get_bool("Report material benchmark");
+		report_allocations = prm.get_bool("Report allocations");
+	}
+	prm.leave_subsection();
+}
+
+
 template <int dim>
 void Solid<dim>::run()
 {
+	if (number_threads > 0)
+	{
+		MultithreadInfo::set_thread_limit(number_threads);
+	}
+	std::cout << "Number of threads used for the assembly: "
+			<< MultithreadInfo::n_threads() << std::endl;
+
 	make_grid();
 	system_setup();
+	if (report_renumbering)
+	{
+		print_renumbering_comparison();
+	}
+	if (report_assembly_scaling)
+	{
+		print_assembly_scaling();
+	}
+	if (report_material_benchmark)
+	{
+		print_material_benchmark();
+	}
 	//output initial values (here: =0)
 	output_results();
-	//Loop over the number of load_steps (see class declaration)
-	for (current_load_step=1; current_load_step <= load_steps; current_load_step++)
+	//Loop over the load increments, load_steps equal ones unless they are adapted
+	load_fraction_n = 0.0;
+	double load_increment = 1.0 / load_steps;
+	current_load_step = 0;
+	converged_increments.clear();
+	unsigned int n_newton_iterations_saved = 0;
+	while (load_fraction_n < 1.0 - 1e-12)
 	{
+			load_increment = std::min(load_increment, 1.0 - load_fraction_n);
+			load_fraction = load_fraction_n + load_increment;
+			++current_load_step;
 			/*Always reset the increment vector - not to be mistaken with
 			 the newton update!!!*/
 			solution_delta = 0.0;
 			/*Compute for the current load step the incremental solution using
 			 Newton-Rapshon*/
-			solve_load_step_NR(solution_delta);
+			unsigned int newton_iterations = 0;
+			bool failed_load_step = false;
+			if (!adaptive_load_stepping)
+			{
+				newton_iterations = solve_load_step_NR(solution_delta);
+				if (report_predictor_savings && predictor_type != "None")
+				{
+					const unsigned int newton_iterations_reference = count_newton_iterations_without_predictor();
+					std::cout << "Newton iterations with predictor: " << newton_iterations
+							<< ", without: " << newton_iterations_reference << std::endl;
+					if (newton_iterations_reference > newton_iterations)
+					{
+						n_newton_iterations_saved += newton_iterations_reference - newton_iterations;
+					}
+				}
+			}
+			else
+			{
+				try
+				{
+					newton_iterations = solve_load_step_NR(solution_delta);
+				}
+				catch (const StrainMeasures::InvalidDeformation &exc)
+				{
+					std::cout << std::endl << "Load step failed: " << exc.what() << std::endl;
+					failed_load_step = true;
+				}
+				catch (const ExcNonlinearNoConvergence &)
+				{
+					std::cout << std::endl << "Load step failed: no convergence in nonlinear solver" << std::endl;
+					failed_load_step = true;
+				}
+				catch (const SolverControl::NoConvergence &exc)
+				{
+					std::cout << std::endl << "Load step failed: no convergence in linear solver after "
+							<< exc.last_step << " iterations" << std::endl;
+					failed_load_step = true;
+				}
+				if (failed_load_step)
+				{
+					/*Discard the increment and everything gathered at the iterates of the failed
+					 attempt: the L-BFGS pairs, the recycled solutions and the tangent, which the
+					 tangent predictor would otherwise reuse. Then repeat the step with a smaller
+					 increment*/
+					n_bfgs_pairs = 0;
+					recycling_subspace.clear();
+					preconditioner_policy.invalidate();
+					tangent_discarded = true;
+					--current_load_step;
+					load_increment *= load_increment_cutback;
+					AssertThrow (load_increment >= load_increment_min,
+								ExcMessage("Load increment below load_increment_min"));
+					std::cout << "Cutback of the load increment to " << load_increment << std::endl;
+					continue;
+				}
+			}
 			/*add the converged delta to the solution - not to be mistaken with
 			 the newton update!!!*/
 			solution_n += solution_delta;
+			/*Keep the increments the predictors extrapolate from*/
+			converged_increments.emplace_front(load_fraction - load_fraction_n, solution_delta);
+			if (converged_increments.size() > 2)
+			{
+				converged_increments.pop_back();
+			}
+			load_fraction_n = load_fraction;
 			output_results();
+
+			if (adaptive_load_stepping && newton_iterations <= newton_iterations_fast)
+			{
+				load_increment = std::min(load_increment * load_increment_growth, load_increment_max);
+			}
+	}
+	std::cout << "Total load applied in " << current_load_step << " load steps" << std::endl;
+	if (solver_type == "DeflatedCG")
+	{
+		std::cout << "CG iterations with recycling: " << n_lin_it_deflated
+				<< " (+ " << n_deflation_products << " products for the deflation setup)" << std::endl;
+		if (report_recycling_savings)
+		{
+			std::cout << "CG iterations without recycling: " << n_lin_it_reference
+					<< ", saved: " << (static_cast<long>(n_lin_it_reference) - n_lin_it_deflated)
+					<< ", saved incl. setup: "
+					<< (static_cast<long>(n_lin_it_reference) - n_lin_it_deflated - n_deflation_products)
+					<< std::endl;
+		}
+	}
+	if (report_predictor_savings && predictor_type != "None")
+	{
+		std::cout << "Newton iterations saved by the predictor: " << n_newton_iterations_saved << std::endl;
 	}
 }
 
@@ -235,6 +1231,11 @@ void Solid<dim>::run()
 template <int dim>
 void Solid<dim>::make_grid()
 {
+	/*The multigrid hierarchy needs neighbouring levels to differ by at most one at every vertex*/
+	if (preconditioner_type == "Multigrid")
+	{
+		triangulation.set_mesh_smoothing(Triangulation<dim>::limit_level_difference_at_vertices);
+	}
 	HyperCubeWithRefinedHole::generate_grid<dim>(triangulation,
 												 nbr_adaptive_refinements,
 												id_Dirichlet_boundary,
@@ -255,18 +1256,16 @@ void Solid<dim>::make_grid()
 template <int dim>
 void Solid<dim>::system_setup()
 {
+	setup_dofs();
 
-	
-	dof_handler_ref.distribute_dofs(fe);
-
-
- 	DoFRenumbering::Cuthill_McKee(dof_handler_ref);
-// 	DoFRenumbering::random(dof_handler_ref);
+	setup_reference_geometry();
+	select_cell_quadrature_kernel();
 
-	
-	constraints.clear();
-	DoFTools::make_hanging_node_constraints (dof_handler_ref,constraints);
-	constraints.close();
+	if (precompute_external_load)
+	{
+		setup_external_load();
+		std::cout << "External load precomputed on " << neumann_faces.size() << " Neumann faces" << std::endl;
+	}
 	
 	std::cout << "Triangulation:"
 				<< "\n\t Number of active cells: " << triangulation.n_active_cells()
@@ -274,406 +1273,2460 @@ void Solid<dim>::system_setup()
 				<< std::endl;
 
 
-	tangent_matrix.clear();
+	recycling_subspace.max_dimension = recycling_dimension;
 	const types::global_dof_index n_dofs_u = dof_handler_ref.n_dofs();
+	system_rhs.reinit(n_dofs_u);
+	solution_delta.reinit(n_dofs_u);
+	solution_n.reinit(n_dofs_u);
 
-	/*Due to internal data structure of deal.ii classes (estimation of memory) a DynamicSparsityPattern is used
-	 * first (different structre than the SparsityPattern itself) - Details in the Sparsity pattern module
-	 */
-	DynamicSparsityPattern dsp(n_dofs_u, n_dofs_u);
-	DoFTools::make_sparsity_pattern(dof_handler_ref,
-								dsp,
-								constraints,
-								true);//true);//dont keep constraint dof sparsity pattern entries
-	sparsity_pattern.copy_from (dsp);
+	/*All vectors of the Newton loop are allocated here once, the iterations only
+	 overwrite them*/
+	newton_update.reinit(n_dofs_u);
+	solution_total.reinit(n_dofs_u);
+	linear_residual.reinit(solver_type == "Direct" ? n_dofs_u : 0);
+	residual_jacobian_free.reinit(solver_type == "JFNK" ? n_dofs_u : 0);
+	const bool use_bfgs = (nonlinear_solver_type == "BFGS" || nonlinear_solver_type == "Auto");
+	bfgs_pairs.resize(use_bfgs ? bfgs_memory + 1 : 0);
+	for (BFGSPair &pair : bfgs_pairs)
+	{
+		pair.s.reinit(n_dofs_u);
+		pair.y.reinit(n_dofs_u);
+	}
+	n_bfgs_pairs = 0;
+	update_previous.reinit(use_bfgs ? n_dofs_u : 0);
+	rhs_previous.reinit(use_bfgs ? n_dofs_u : 0);
+	quasi_newton_rhs.reinit(use_bfgs ? n_dofs_u : 0);
+	/*The scratch objects of the threads read the current solution from solution_total*/
+	const UpdateFlags uf_face(update_values | update_normal_vectors | update_JxW_values);
+	scratch_pool.reset(new Threads::ThreadLocalStorage<ScratchData_ASM>(
+						ScratchData_ASM(fe, qf_face, uf_face, solution_total)));
+	scratch_pool_batch.reset(new Threads::ThreadLocalStorage<ScratchData_Batch>(
+							ScratchData_Batch(fe, qf_face, uf_face, solution_total)));
+	/*Those of the trial states read from solution_total_trial*/
+	solution_delta_trial.reinit(line_search_type == "Energy" ? n_dofs_u : 0);
+	solution_total_trial.reinit(n_dofs_u);
+	scratch_serial.reset(new ScratchData_ASM(fe, qf_face, uf_face, solution_total_trial));
+	scratch_pool_residual.reset(new Threads::ThreadLocalStorage<ScratchData_ASM>(
+								ScratchData_ASM(fe, qf_face, uf_face, solution_total_trial)));
+	scratch_level.reset(preconditioner_type == "Multigrid" ? new ScratchData_Level(fe, qf_cell) : nullptr);
+
+	if (tangent_type == "MatrixFree")
+	{
+		/*No sparsity pattern and matrix are needed, the MatrixFree data is set up
+		 together with the constraints in make_constraints()*/
+		mf_operator = create_NeoHookeanOperator<dim>(degree, n_q_points_1d, mu, lambda);
+		return;
+	}
+
+	setup_sparsity_pattern();
+	if (tangent_type == "SparseSymmetric")
+	{
+		/*Only the upper triangle is allocated*/
+		std::cout<<"Size of the upper triangle of the sparsity-pattern: "
+				<<tangent_matrix_sym.n_nonzero_elements()<<std::endl;
+		std::cout<<"Memory of the tangent matrix: "
+				<<tangent_matrix_sym.memory_consumption() / 1024. / 1024. << " MiB"<<std::endl;
+		return;
+	}
+	if (tangent_type == "BlockSparse")
+	{
+		/*One column index per dim x dim block instead of one per entry*/
+		std::cout<<"Number of "<<dim<<"x"<<dim<<" blocks: "
+				<<tangent_matrix_bsr.n_nonzero_elements() / (dim*dim)
+				<<" ("<<tangent_matrix_bsr.n_nonzero_elements()<<" entries)"<<std::endl;
+		std::cout<<"Memory of the tangent matrix: "
+				<<tangent_matrix_bsr.memory_consumption() / 1024. / 1024. << " MiB"<<std::endl;
+		return;
+	}
 
 	unsigned int number_entries = sparsity_pattern.n_nonzero_elements();
 	std::cout<<"Size of sparsity-pattern: "<<number_entries<<std::endl;
 	std::ofstream out ("sparsity_pattern1.svg");
 	sparsity_pattern.print_svg (out);	
 	
-	tangent_matrix.reinit (sparsity_pattern);
-	system_rhs.reinit(n_dofs_u);
-	solution_delta.reinit(n_dofs_u);
-	solution_n.reinit(n_dofs_u);
+	std::cout<<"Memory of the tangent matrix: "
+			<<(sparsity_pattern.memory_consumption() + tangent_matrix.memory_consumption()) / 1024. / 1024.
+			<< " MiB"<<std::endl;
+
+	if (preconditioner_type == "Multigrid")
+	{
+		multigrid.initialize(dof_handler_ref, {types::boundary_id(id_Dirichlet_boundary)});
+		std::cout<<"Number of multigrid levels: "<<multigrid.n_levels()<<std::endl;
+		std::cout<<"Memory of the multigrid hierarchy: "
+				<<multigrid.memory_consumption() / 1024. / 1024. << " MiB"<<std::endl;
+	}
 }
 
 
 template <int dim>
-void Solid<dim>::solve_load_step_NR(Vector<double> &solution_delta)
+void Solid<dim>::setup_dofs()
 {
-	/*A vector used for all the newton increments*/
-	Vector<double> newton_update(dof_handler_ref.n_dofs());
-	/*Reset the structs used for convergence criteria*/
-	error_residual.reset();
-	error_residual_0.reset();
-	error_residual_norm.reset();
-	/*Print info to the screen*/
-	print_conv_header();
+	/*Release the preconditioners of a previous setup before their matrices change*/
+	preconditioner_chebyshev.reset();
+	preconditioner_jacobi.reset();
+	preconditioner_policy.invalidate();
+	preconditioner_set_up = false;
+#ifdef DEAL_II_WITH_UMFPACK
+	direct_solver.clear();
+	factorization_current = false;
+#endif
+	recycling_subspace.clear();
+	tangent_matrix.clear();
 
-	unsigned int newton_iteration = 0;
-	for (; newton_iteration <= max_number_newton_iterations;
-			++newton_iteration)
+	dof_handler_ref.distribute_dofs(fe);
+	if (preconditioner_type == "Multigrid")
 	{
-		std::cout << " " << std::setw(2) << newton_iteration << " " << std::flush;
-
-
-		//BEGIN - INSERT YOUR CODE HERE
-		//RESET THE TANGENT MATRIX, THE RHS
-		//CALL THE FUNCTIONS make_constraints (WITH THE CORRECT PARAMETER)
-		//AND ASSEMBLE_SYSTEM
-		tangent_matrix = 0.0;
-		system_rhs = 0.0;
-		make_constraints(newton_iteration);
-		assemble_system();
-		
-		//END - INSERT YOUR CODE HERE
-
-		get_error_residual(error_residual);
-		if (newton_iteration == 0)
-		{
-			error_residual_0 = error_residual;
-		}
-		error_residual_norm = error_residual;
-		error_residual_norm.normalise(error_residual_0);
+		dof_handler_ref.distribute_mg_dofs();
+	}
 
-		/*Problem has to be solved at least once*/
-		if (newton_iteration > 0 && error_residual_norm.u <= error_tolerance_residual)
-		{
-			std::cout << " CONVERGED! " << std::endl;
-			/*Print info to the screen*/
-			print_conv_footer();
-			break;
-		}
-		
-		
-		const std::pair<unsigned int, double>
-		lin_solver_output = solve_linear_system(newton_update);
-		//BEGIN - INSERT YOUR CODE HERE
-		//ADD THE NEWTION INCREMENT TO THE LOAD STEP DELTA solution_delta
-		solution_delta += newton_update;
-		//END - INSERT YOUR CODE HERE
-		
-		
-		/*Print info to the screen*/
-		std::cout << " | " << std::fixed << std::setprecision(3) << std::setw(7)
-					<< std::scientific << lin_solver_output.first << "  "
-					<< lin_solver_output.second << "  " << error_residual_norm.u 
-					<< "  " << std::endl;
+	renumber_dofs();
+	if (tangent_type == "BlockSparse")
+	{
+		renumber_dofs_nodewise();
 	}
-	  AssertThrow (newton_iteration < max_number_newton_iterations,
-               ExcMessage("No convergence in nonlinear solver!"));	
+
+	constraints.clear();
+	DoFTools::make_hanging_node_constraints (dof_handler_ref,constraints);
+	constraints.close();
 }
 
+
 template <int dim>
-void Solid<dim>::print_conv_header()
+void Solid<dim>::setup_sparsity_pattern()
 {
-	double step_fraction = double(current_load_step)/double(load_steps);
-	double current_load = load_magnitude * step_fraction;
-	std::cout << "\nStep " << current_load_step << " out of "
-			<< load_steps << " load steps with current load: "<<step_fraction<<"*"
-			<<load_magnitude<<" = "<<current_load << std::endl;
-
-	const unsigned int l_width = 90;
+	/*Due to internal data structure of deal.ii classes (estimation of memory) a DynamicSparsityPattern is used
+	 * first (different structre than the SparsityPattern itself) - Details in the Sparsity pattern module
+	 */
+	const types::global_dof_index n_dofs_u = dof_handler_ref.n_dofs();
+	DynamicSparsityPattern dsp(n_dofs_u, n_dofs_u);
+	DoFTools::make_sparsity_pattern(dof_handler_ref,
+								dsp,
+								constraints,
+								true);//true);//dont keep constraint dof sparsity pattern entries
+	if (tangent_type == "SparseSymmetric")
+	{
+		tangent_matrix_sym.reinit(dsp);
+	}
+	else if (tangent_type == "BlockSparse")
+	{
+		tangent_matrix_bsr.reinit(dsp);
+	}
+	else
+	{
+		sparsity_pattern.copy_from (dsp);
+		tangent_matrix.reinit (sparsity_pattern);
+	}
+}
+
+
+template <int dim>
+void Solid<dim>::renumber_dofs()
+{
+	if (renumbering_type == "CuthillMcKee")
+	{
+		DoFRenumbering::Cuthill_McKee(dof_handler_ref);
+	}
+	else if (renumbering_type == "ReverseCuthillMcKee")
+	{
+		DoFRenumbering::Cuthill_McKee(dof_handler_ref, true);
+	}
+	else if (renumbering_type == "King")
+	{
+		DoFRenumbering::boost::king_ordering(dof_handler_ref);
+	}
+	else if (renumbering_type == "MinimumDegree")
+	{
+		DoFRenumbering::boost::minimum_degree(dof_handler_ref);
+	}
+	else if (renumbering_type == "ComponentWise")
+	{
+		DoFRenumbering::component_wise(dof_handler_ref);
+	}
+	else if (renumbering_type == "BlockWise")
+	{
+		/*Every vector component of the FESystem is a block of its own*/
+		DoFRenumbering::block_wise(dof_handler_ref);
+	}
+	else if (renumbering_type == "Hierarchical")
+	{
+		DoFRenumbering::hierarchical(dof_handler_ref);
+	}
+	else if (renumbering_type == "SpaceFillingCurve")
+	{
+		/*Morton key of the cell center: its coordinates relative to the bounding box of
+		 the mesh on a grid of 2^n_bits points per direction, the bits interleaved from
+		 the most significant one on*/
+		const unsigned int n_bits = 64 / dim;
+		const double n_grid_points = double((std::uint64_t(1) << n_bits) - 1);
+		Point<dim> lower = triangulation.begin_active()->center();
+		Point<dim> upper = lower;
+		for (const auto &cell : triangulation.active_cell_iterators())
+		{
+			for (unsigned int d = 0; d < dim; ++d)
+			{
+				lower[d] = std::min(lower[d], cell->center()[d]);
+				upper[d] = std::max(upper[d], cell->center()[d]);
+			}
+		}
+
+		typedef typename DoFHandler<dim>::active_cell_iterator CellIterator;
+		std::vector<std::pair<std::uint64_t, CellIterator> > cell_keys;
+		cell_keys.reserve(triangulation.n_active_cells());
+		for (const CellIterator &cell : dof_handler_ref.active_cell_iterators())
+		{
+			std::array<std::uint64_t, dim> coordinates;
+			for (unsigned int d = 0; d < dim; ++d)
+			{
+				const double extent = upper[d] - lower[d];
+				coordinates[d] = (extent > 0. ? std::uint64_t((cell->center()[d] - lower[d]) / extent * n_grid_points)
+											: 0);
+			}
+			std::uint64_t key = 0;
+			for (unsigned int bit = n_bits; bit-- > 0;)
+				for (unsigned int d = 0; d < dim; ++d)
+				{
+					key = (key << 1) | ((coordinates[d] >> bit) & 1U);
+				}
+			cell_keys.emplace_back(key, cell);
+		}
+		std::stable_sort(cell_keys.begin(), cell_keys.end(),
+						[](const std::pair<std::uint64_t, CellIterator> &a,
+						const std::pair<std::uint64_t, CellIterator> &b)
+						{
+							return a.first < b.first;
+						});
+
+		/*The dofs are numbered cell by cell in the order of the curve*/
+		std::vector<CellIterator> cell_order;
+		cell_order.reserve(cell_keys.size());
+		for (const auto &cell_key : cell_keys)
+		{
+			cell_order.push_back(cell_key.second);
+		}
+		DoFRenumbering::cell_wise(dof_handler_ref, cell_order);
+	}
+	else if (renumbering_type == "Random")
+	{
+		DoFRenumbering::random(dof_handler_ref);
+	}
+	else
+	{
+		AssertThrow (renumbering_type == "None",
+					ExcMessage("Renumbering type " + renumbering_type + " not implemented"));
+	}
+}
+
+
+template <int dim>
+void Solid<dim>::renumber_dofs_nodewise()
+{
+	const types::global_dof_index n_dofs = dof_handler_ref.n_dofs();
+	/*Every node is identified by the smallest index of its dofs*/
+	std::vector<types::global_dof_index> node_of_dof(n_dofs, numbers::invalid_dof_index);
+	std::vector<unsigned int> component_of_dof(n_dofs, 0);
+
+	const unsigned int dofs_per_node_and_cell = fe.base_element(0).dofs_per_cell;
+	std::vector<types::global_dof_index> local_dof_indices(dofs_per_cell);
+	std::vector<types::global_dof_index> first_dof_of_node(dofs_per_node_and_cell);
+	typename DoFHandler<dim>::active_cell_iterator cell = dof_handler_ref.begin_active(),
+												endc = dof_handler_ref.end();
+	for(;cell!=endc;++cell)
+	{
+		cell->get_dof_indices(local_dof_indices);
+		/*Shape functions with the same base index belong to the same support point*/
+		std::fill(first_dof_of_node.begin(), first_dof_of_node.end(), numbers::invalid_dof_index);
+		for(unsigned int i=0; i<dofs_per_cell; ++i)
+		{
+			const unsigned int base_index = fe.system_to_component_index(i).second;
+			first_dof_of_node[base_index] = std::min(first_dof_of_node[base_index], local_dof_indices[i]);
+		}
+		for(unsigned int i=0; i<dofs_per_cell; ++i)
+		{
+			node_of_dof[local_dof_indices[i]] = first_dof_of_node[fe.system_to_component_index(i).second];
+			component_of_dof[local_dof_indices[i]] = fe.system_to_component_index(i).first;
+		}
+	}
+
+	std::vector<types::global_dof_index> node_number(n_dofs, numbers::invalid_dof_index);
+	types::global_dof_index n_nodes = 0;
+	for(types::global_dof_index i=0; i<n_dofs; ++i)
+	{
+		if (node_of_dof[i] == i)
+		{
+			node_number[i] = n_nodes++;
+		}
+	}
+	AssertThrow (n_nodes * dim == n_dofs,
+				ExcMessage("Dofs can not be grouped into nodes of dim components"));
+
+	std::vector<types::global_dof_index> new_numbers(n_dofs);
+	for(types::global_dof_index i=0; i<n_dofs; ++i)
+	{
+		new_numbers[i] = node_number[node_of_dof[i]] * dim + component_of_dof[i];
+	}
+	dof_handler_ref.renumber_dofs(new_numbers);
+}
+
+
+template <int dim>
+void Solid<dim>::print_material_benchmark()
+{
+	NeoHookeanMaterial<dim> material(this->mu, this->lambda);
+	const unsigned int n_samples = 1000;
+	const unsigned int n_repetitions = 1000;
+
+	//Deformation gradients of moderate, deterministic deformations around the identity
+	std::vector<Tensor<2,dim> > DeformationGradients(n_samples,
+								Tensor<2, dim>(Physics::Elasticity::StandardTensors<dim>::I));
+	for(unsigned int s=0; s<n_samples; ++s)
+	{
+		for(unsigned int d=0; d<dim; ++d)
+			for(unsigned int e=0; e<dim; ++e)
+			{
+				DeformationGradients[s][d][e] += 0.1 * std::sin(1.0 + s + 3*d + 7*e);
+			}
+	}
+
+	//Results are summed up such that the compiler can not drop the evaluations
+	double checksum_separate = 0.0;
+	Timer timer;
+	for(unsigned int r=0; r<n_repetitions; ++r)
+	{
+		for(const Tensor<2,dim> &F : DeformationGradients)
+		{
+			const SymmetricTensor<2,dim> Kirchhoffstress = material.get_KirchhoffStress(F);
+			const SymmetricTensor<4,dim> Tangent = material.get_Tangent_spt(F);
+			const Tensor<2,dim> F_inv = invert(F);
+			checksum_separate += Kirchhoffstress[0][0] + Tangent[0][0][0][0] + F_inv[0][0];
+		}
+	}
+	timer.stop();
+	const double time_separate = timer.wall_time();
+
+	double checksum_fused = 0.0;
+	typename NeoHookeanMaterial<dim>::Evaluation material_point;
+	timer.restart();
+	for(unsigned int r=0; r<n_repetitions; ++r)
+	{
+		for(const Tensor<2,dim> &F : DeformationGradients)
+		{
+			material.evaluate(F, material_point);
+			checksum_fused += material_point.KirchhoffStress[0][0]
+							+ material_point.Tangent_spt[0][0][0][0] + material_point.F_inv[0][0];
+		}
+	}
+	timer.stop();
+	const double time_fused = timer.wall_time();
+
+	double max_difference = 0.0;
+	for(const Tensor<2,dim> &F : DeformationGradients)
+	{
+		material.evaluate(F, material_point);
+		max_difference = std::max(max_difference,
+							(material.get_KirchhoffStress(F) - material_point.KirchhoffStress).norm());
+		max_difference = std::max(max_difference,
+							(material.get_Tangent_spt(F) - material_point.Tangent_spt).norm());
+	}
+
+	const double n_evaluations = double(n_samples) * n_repetitions;
+	std::cout << "\nMaterial evaluation (" << n_evaluations << " evaluations):" << std::endl
+			<< std::scientific << std::setprecision(3)
+			<< "\t separate getters: " << time_separate / n_evaluations * 1e9 << " ns per point" << std::endl
+			<< "\t fused evaluate:   " << time_fused / n_evaluations * 1e9 << " ns per point" << std::endl
+			<< "\t speedup: " << std::fixed << std::setprecision(2) << time_separate / time_fused << std::endl
+			<< "\t max. difference: " << std::scientific << max_difference
+			<< " (checksums " << checksum_separate << ", " << checksum_fused << ")" << std::endl;
+}
+
+
+template <int dim>
+void Solid<dim>::setup_reference_geometry()
+{
+	FEValues<dim> fe_values_ref (fe,
+								qf_cell,
+								update_gradients|
+								update_JxW_values);
+
+	reference_geometry.reinit(triangulation.n_active_cells(), n_q_points, dofs_per_cell);
+	for(unsigned int i=0; i<dofs_per_cell; ++i)
+	{
+		reference_geometry.shape_component[i] = fe.system_to_component_index(i).first;
+	}
+
+	typename DoFHandler<dim>::active_cell_iterator cell = dof_handler_ref.begin_active(),
+												endc = dof_handler_ref.end();
+	for(;cell!=endc;++cell)
+	{
+		fe_values_ref.reinit(cell);
+		const unsigned int cell_index = cell->active_cell_index();
+		for(unsigned int k=0; k<n_q_points;++k)
+		{
+			reference_geometry.JxW(cell_index, k) = fe_values_ref.JxW(k);
+			Tensor<1,dim> *shape_gradients_ref = reference_geometry.shape_gradients_at(cell_index, k);
+			for(unsigned int i=0; i<dofs_per_cell; ++i)
+			{
+				shape_gradients_ref[i] = fe_values_ref.shape_grad_component(i, k,
+																reference_geometry.shape_component[i]);
+			}
+		}
+	}
+
+	std::cout << "Memory of the reference geometry cache: "
+			<< reference_geometry.memory_consumption() / 1024. << " KiB" << std::endl;
+
+	cell_batches.clear();
+	for(cell = dof_handler_ref.begin_active(); cell!=endc; ++cell)
+	{
+		if (cell_batches.empty() || cell_batches.back().size() == VectorizedArray<double>::n_array_elements)
+		{
+			cell_batches.emplace_back();
+		}
+		cell_batches.back().push_back(cell);
+	}
+	if (vectorized_assembly)
+	{
+		std::cout << "Vectorized assembly: " << cell_batches.size() << " batches of "
+				<< VectorizedArray<double>::n_array_elements << " cells" << std::endl;
+	}
+}
+
+
+template <int dim>
+void Solid<dim>::setup_external_load()
+{
+	neumann_faces.clear();
+	typename DoFHandler<dim>::active_cell_iterator cell = dof_handler_ref.begin_active(),
+												endc = dof_handler_ref.end();
+	for(;cell!=endc;++cell)
+	{
+		for(unsigned int face=0; face < GeometryInfo<dim>::faces_per_cell; ++face)
+		{
+			if(cell->face(face)->at_boundary() && cell->face(face)->boundary_id() == id_Neumann_boundary )
+			{
+				neumann_faces.emplace_back(cell, face);
+			}
+		}
+	}
+
+	//The unit traction is the normal vector of the reference configuration
+	FEFaceValues<dim> fe_face_values_ref(fe, qf_face, update_values | update_normal_vectors | update_JxW_values);
+	Vector<double> cell_rhs(dofs_per_cell);
+	std::vector<types::global_dof_index> local_dof_indices(dofs_per_cell);
+	external_load_unit_reference.reinit(dof_handler_ref.n_dofs());
+	for (const BoundaryFace &neumann_face : neumann_faces)
+	{
+		fe_face_values_ref.reinit(neumann_face.first, neumann_face.second);
+		cell_rhs = 0.0;
+		for(unsigned int f_q_point = 0; f_q_point < n_q_points_f; ++f_q_point)
+		{
+			const Tensor<1,dim> NormalVector = fe_face_values_ref.normal_vector(f_q_point);
+			for(unsigned int i = 0; i< dofs_per_cell; ++i)
+			{
+				cell_rhs(i) += (fe_face_values_ref[u_fe].value(i,f_q_point) * NormalVector)
+								* fe_face_values_ref.JxW(f_q_point);
+			}
+		}
+		neumann_face.first->get_dof_indices(local_dof_indices);
+		for(unsigned int i = 0; i< dofs_per_cell; ++i)
+		{
+			external_load_unit_reference(local_dof_indices[i]) += cell_rhs(i);
+		}
+	}
+	condense_external_load();
+}
+
+
+template <int dim>
+void Solid<dim>::condense_external_load()
+{
+	/*The constraints are homogeneous, i.e. condensing the global vector gives the same
+	 as distributing the local contributions*/
+	external_load_unit = external_load_unit_reference;
+	constraints.condense(external_load_unit);
+}
+
+
+template <int dim>
+unsigned int Solid<dim>::solve_load_step_NR(Vector<double> &solution_delta)
+{
+	/*The newton increments are written into the member newton_update, all vectors of
+	 the loop are allocated in system_setup()*/
+	/*Reset the structs used for convergence criteria*/
+	error_residual.reset();
+	error_residual_0.reset();
+	error_residual_norm.reset();
+	/*Print info to the screen*/
+	print_conv_header();
+	preconditioner_policy.new_load_step();
+	n_lin_it_saved = 0;
+	n_allocations_first_iteration.fill(0);
+	n_allocations_further_iterations.fill(0);
+	/*Norm of the residual and relative tolerance of the previous Newton iteration*/
+	double error_residual_previous = 0.0;
+	double forcing_term = relative_tolerance_linear_solver;
+	/*Bookkeeping of the tangent reuse: update and rhs of the previous iteration for the
+	 L-BFGS pairs*/
+	n_tangent_assemblies = 0;
+	n_bfgs_pairs = 0;
+	const bool use_bfgs = (nonlinear_solver_type == "BFGS" || nonlinear_solver_type == "Auto");
+	unsigned int iterations_since_tangent = 0;
+	/*With JFNK the tangent only preconditions the exact Jacobian action, i.e. Newton
+	 keeps it as long as ModifiedNewton*/
+	const bool lagged_tangent = (nonlinear_solver_type == "ModifiedNewton"
+								|| (nonlinear_solver_type == "Newton" && solver_type == "JFNK"));
+	/*Auto continues with modified Newton steps after a rejected secant pair*/
+	bool auto_modified_newton = false;
+	/*Contraction of the residual in the previous Newton iteration*/
+	double contraction_previous = 1.0;
+
+	/*With a predictor the residuals are still normalised with the residual at
+	 solution_delta = 0, such that the convergence criterion does not change*/
+	const bool use_predictor = (predictor_type != "None"
+								&& converged_increments.size() >= (predictor_type == "Quadratic" ? 2 : 1));
+	if (use_predictor)
+	{
+		std::cout << " PRD " << std::flush;
+		{
+			AllocationCounter::Scope count(n_allocations_first_iteration[allocations_constraints]);
+			make_constraints(0);
+		}
+		{
+			AllocationCounter::Scope count(n_allocations_first_iteration[allocations_assembly]);
+			system_rhs = 0.0;
+			assemble_system(residual_only);
+		}
+		{
+			AllocationCounter::Scope count(n_allocations_first_iteration[allocations_residual_norm]);
+			get_error_residual(error_residual_0);
+		}
+		{
+			AllocationCounter::Scope count(n_allocations_first_iteration[allocations_update]);
+			predict_solution_delta(solution_delta);
+		}
+		std::cout << std::endl;
+	}
+
+	unsigned int newton_iteration = 0;
+	for (; newton_iteration <= max_number_newton_iterations;
+			++newton_iteration)
+	{
+		std::cout << " " << std::setw(2) << newton_iteration << " " << std::flush;
+		std::array<unsigned long long, n_allocation_phases> &n_allocations
+			= (newton_iteration == 0 ? n_allocations_first_iteration : n_allocations_further_iterations);
+
+
+		/*Newton and ModifiedNewton know in advance whether this iteration needs a tangent,
+		 which is then assembled in the same pass over the cells as the residual. Only the
+		 residual is assembled if the iteration is expected to converge, estimated from the
+		 previous contraction (quadratic for Newton, linear otherwise). The quasi-Newton
+		 variants decide from the new residual, i.e. they assemble the tangent separately*/
+		const bool tangent_scheduled = (newton_iteration == 0
+										|| (nonlinear_solver_type == "Newton" && !lagged_tangent)
+										|| (lagged_tangent && iterations_since_tangent >= tangent_update_interval));
+		const double residual_estimate = error_residual_norm.u * contraction_previous
+										* (nonlinear_solver_type == "Newton" ? contraction_previous : 1.0);
+		const bool assemble_with_residual = (tangent_scheduled && tangent_type != "MatrixFree"
+											&& (newton_iteration == 0 || residual_estimate > error_tolerance_residual));
+
+		//BEGIN - INSERT YOUR CODE HERE
+		//RESET THE RHS
+		//CALL THE FUNCTIONS make_constraints (WITH THE CORRECT PARAMETER)
+		//AND ASSEMBLE_SYSTEM - ONLY THE RESIDUAL IS NEEDED FOR THE CONVERGENCE CHECK
+		{
+			AllocationCounter::Scope count(n_allocations[allocations_constraints]);
+			make_constraints(newton_iteration);
+		}
+		{
+			AllocationCounter::Scope count(n_allocations[allocations_assembly]);
+			system_rhs = 0.0;
+			if (assemble_with_residual)
+			{
+				reset_tangent();
+				assemble_system(residual_and_tangent);
+			}
+			else
+			{
+				assemble_system(residual_only);
+			}
+		}
+		
+		//END - INSERT YOUR CODE HERE
+
+		{
+			AllocationCounter::Scope count(n_allocations[allocations_residual_norm]);
+			get_error_residual(error_residual);
+			if (newton_iteration == 0 && !use_predictor)
+			{
+				error_residual_0 = error_residual;
+			}
+			error_residual_norm = error_residual;
+			error_residual_norm.normalise(error_residual_0);
+		}
+
+		/*Problem has to be solved at least once*/
+		if (newton_iteration > 0 && error_residual_norm.u <= error_tolerance_residual)
+		{
+			std::cout << " CONVERGED! " << std::endl;
+			/*Print info to the screen*/
+			print_conv_footer();
+			break;
+		}
+
+		/*The tangent is only assembled if the update is actually computed, and only
+		 as often as the nonlinear solver type requires*/
+		const double contraction = (error_residual_previous > 0.0
+									? error_residual.u / error_residual_previous : 0.0);
+		contraction_previous = (error_residual_previous > 0.0 ? contraction : 1.0);
+		/*The fixed interval only applies to ModifiedNewton, the quasi-Newton variants
+		 reassemble depending on the contraction of the residual*/
+		bool assemble_tangent = tangent_scheduled;
+		if (nonlinear_solver_type == "BFGS")
+		{
+			/*Diverging quasi-Newton iterations*/
+			assemble_tangent = assemble_tangent || contraction >= 1.0;
+		}
+		else if (nonlinear_solver_type == "Auto")
+		{
+			/*Slow convergence: full Newton step instead. The modified Newton steps keep the
+			 tangent as long as ModifiedNewton would*/
+			assemble_tangent = assemble_tangent || contraction > auto_contraction_max
+								|| (auto_modified_newton && iterations_since_tangent >= tangent_update_interval);
+		}
+		else
+		{
+			AssertThrow (nonlinear_solver_type == "Newton" || nonlinear_solver_type == "ModifiedNewton",
+						ExcMessage("Nonlinear solver type " + nonlinear_solver_type + " not implemented"));
+		}
+
+		Assert (assemble_tangent || !assemble_with_residual, ExcInternalError());
+		if (assemble_tangent)
+		{
+			AllocationCounter::Scope count(n_allocations[allocations_assembly]);
+			update_tangent(assemble_with_residual);
+			iterations_since_tangent = 0;
+			n_bfgs_pairs = 0;
+			auto_modified_newton = false;
+		}
+		else if (use_bfgs && bfgs_memory > 0 && !auto_modified_newton)
+		{
+			AllocationCounter::Scope count(n_allocations[allocations_update]);
+			/*Secant pair of the last update in the free slot behind the stored pairs,
+			 skipped if the curvature condition fails. Otherwise it is rotated to the
+			 front and, if the memory is full, the oldest pair drops into the free slot*/
+			BFGSPair &pair = bfgs_pairs[n_bfgs_pairs];
+			pair.s = update_previous;
+			pair.y = rhs_previous;
+			pair.y -= system_rhs;
+			const double ys = pair.y * pair.s;
+			if (ys > 0.0)
+			{
+				pair.rho = 1.0 / ys;
+				std::rotate(bfgs_pairs.begin(),
+							bfgs_pairs.begin() + n_bfgs_pairs,
+							bfgs_pairs.begin() + n_bfgs_pairs + 1);
+				n_bfgs_pairs = std::min(n_bfgs_pairs + 1, bfgs_memory);
+			}
+			else if (nonlinear_solver_type == "Auto")
+			{
+				/*The secant information contradicts the tangent although the residual
+				 contracts well: drop the pairs and take modified Newton steps with the
+				 plain tangent until the next one*/
+				n_bfgs_pairs = 0;
+				auto_modified_newton = true;
+			}
+		}
+		if (auto_modified_newton)
+		{
+			std::cout << " MN " << std::flush;
+		}
+		++iterations_since_tangent;
+		
+		if (forcing_type == "EisenstatWalker")
+		{
+			forcing_term = get_forcing_term(error_residual_previous, forcing_term);
+		}
+		error_residual_previous = error_residual.u;
+
+		const bool use_bfgs_direction = (n_bfgs_pairs > 0);
+		std::pair<unsigned int, double> lin_solver_output;
+		{
+			AllocationCounter::Scope count(n_allocations[allocations_linear_solver]);
+			lin_solver_output = (use_bfgs_direction
+								? solve_quasi_newton(newton_update, forcing_term)
+								: solve_linear_system(newton_update, forcing_term, system_rhs));
+		}
+
+		/*Damp the update if the full step increases the potential energy*/
+		double step_length = 1.0;
+		unsigned int n_line_search_evaluations = 0;
+		{
+			AllocationCounter::Scope count(n_allocations[allocations_update]);
+			if (line_search_type == "Energy")
+			{
+				step_length = line_search(solution_delta, newton_update, n_line_search_evaluations);
+			}
+			//BEGIN - INSERT YOUR CODE HERE
+			//ADD THE NEWTION INCREMENT TO THE LOAD STEP DELTA solution_delta
+			solution_delta.add(step_length, newton_update);
+			//END - INSERT YOUR CODE HERE
+			if (use_bfgs)
+			{
+				update_previous.equ(step_length, newton_update);
+				rhs_previous = system_rhs;
+			}
+		}
+		
+		
+		/*Print info to the screen*/
+		std::cout << " | " << std::fixed << std::setprecision(3) << std::setw(7)
+					<< std::scientific << lin_solver_output.first << "  "
+					<< lin_solver_output.second << "  " << error_residual_norm.u 
+					<< "  " << std::setw(2) << n_line_search_evaluations
+					<< "  " << std::fixed << step_length
+					<< "  " << std::endl;
+	}
+	  AssertThrow (newton_iteration < max_number_newton_iterations,
+               ExcNonlinearNoConvergence());	
+	return newton_iteration;
+}
+
+template <int dim>
+void Solid<dim>::predict_solution_delta(Vector<double> &solution_delta)
+{
+	const double load_increment = load_fraction - load_fraction_n;
+	if (predictor_type == "Linear")
+	{
+		/*u(lambda) linear through the last two converged states*/
+		solution_delta.equ(load_increment / converged_increments[0].first,
+							converged_increments[0].second);
+	}
+	else if (predictor_type == "Quadratic")
+	{
+		/*Lagrange polynomial through the last three converged states at the load fractions
+		 0, -h_1, -(h_1+h_2) relative to the last one, evaluated at load_increment*/
+		const double x = load_increment;
+		const double h_1 = converged_increments[0].first;
+		const double h_2 = converged_increments[1].first;
+		const double L_1 = x * (x + h_1 + h_2) / (-h_1 * h_2);
+		const double L_2 = x * (x + h_1) / ((h_1 + h_2) * h_2);
+		//u_{n-1} - u_n = -d_1 and u_{n-2} - u_n = -(d_1 + d_2)
+		solution_delta.equ(-L_1 - L_2, converged_increments[0].second);
+		solution_delta.add(-L_2, converged_increments[1].second);
+	}
+	else if (predictor_type == "Tangent")
+	{
+		/*One solve with the tangent kept from the last Newton iteration for the residual
+		 at solution_delta = 0, i.e. the increment of the external load*/
+		if (tangent_type == "MatrixFree" || tangent_discarded)
+		{
+			/*make_constraints(0) rebuilt the MatrixFree data and with it cleared the
+			 linearization point, and the tangent of a failed attempt is discarded; both
+			 are set again at the last converged state*/
+			update_tangent();
+		}
+		solve_linear_system(newton_update, relative_tolerance_linear_solver, system_rhs);
+		solution_delta = newton_update;
+	}
+	else
+	{
+		AssertThrow (false, ExcMessage("Predictor type " + predictor_type + " not implemented"));
+	}
+	/*The predicted state has to fulfil the constraints as well*/
+	constraints.distribute(solution_delta);
+}
+
+template <int dim>
+unsigned int Solid<dim>::count_newton_iterations_without_predictor()
+{
+	std::cout << std::endl << "Reference solve of the load step without predictor:";
+	const Vector<double> solution_delta_predicted = solution_delta;
+	const std::string predictor_type_used = predictor_type;
+	predictor_type = "None";
+	solution_delta = 0.0;
+	const unsigned int newton_iterations = solve_load_step_NR(solution_delta);
+	predictor_type = predictor_type_used;
+	solution_delta = solution_delta_predicted;
+	return newton_iterations;
+}
+
+template <int dim>
+void Solid<dim>::print_conv_header()
+{
+	double step_fraction = load_fraction;
+	double current_load = load_magnitude * step_fraction;
+	std::cout << "\nStep " << current_load_step << " with current load: "<<step_fraction<<"*"
+			<<load_magnitude<<" = "<<current_load << std::endl;
+
+	const unsigned int l_width = 90;
 	for (unsigned int i = 0; i < l_width; ++i)
 	{
-		std::cout << "_";
+		std::cout << "_";
+	}
+	std::cout << std::endl;
+
+	std::cout << "           SOLVER STEP            "
+				<< " |  LIN_IT   LIN_RES    RES_NORM     LS_EVAL  LS_STEP"
+				<< std::endl;
+
+	for (unsigned int i = 0; i < l_width; ++i)
+	{
+		std::cout << "_";
+	}
+	std::cout << std::endl;
+}
+
+template <int dim>
+void Solid<dim>::print_conv_footer()
+{
+	const unsigned int l_width = 90;
+	for (unsigned int i = 0; i < l_width; ++i)
+	{
+		std::cout << "_";
+	}
+	std::cout << std::endl;
+
+	std::cout << "Errors:" << std::endl
+				<< "Rhs: \t\t" << error_residual.u << std::endl
+				<< "Tangent assemblies: " << n_tangent_assemblies << std::endl;
+	if (report_forcing_savings)
+	{
+		std::cout << "Linear solver iterations saved by the forcing terms: " << n_lin_it_saved << std::endl;
+	}
+	if (uses_preconditioner_policy())
+	{
+		std::cout << (solver_type == "Direct" ? "Factorization" : "Preconditioner")
+				<< " rebuilt " << preconditioner_policy.n_rebuilds
+				<< " times, reused " << preconditioner_policy.n_reuses << " times" << std::endl;
+	}
+	if (report_allocations)
+	{
+		/*The work vectors, scratch objects and the buffers of the line search, the
+		 residual evaluations and the deflation are not allocated again after the first
+		 iteration. What remains are the per-task copies of WorkStream in every assembly
+		 and residual evaluation of JFNK (depending on the number of threads, not on the
+		 mesh), the solver objects of deal.II in every linear solve, the recycled space
+		 of DeflatedCG until it holds recycling_dimension vectors, and every rebuild of
+		 the preconditioner or the factorization, e.g. of the multigrid levels. The
+		 constraints, the residual norm and the update must not allocate at all*/
+		const std::array<const char *, n_allocation_phases> phase_names
+			= {{"CST", "ASM", "RES", "SLV", "UPD"}};
+		std::cout << "Heap allocations (first iteration/further iterations):";
+		if (AllocationCounter::enabled())
+		{
+			for (unsigned int phase = 0; phase < n_allocation_phases; ++phase)
+			{
+				std::cout << " " << phase_names[phase] << " " << n_allocations_first_iteration[phase]
+						<< "/" << n_allocations_further_iterations[phase];
+			}
+			const bool allocation_free = (n_allocations_further_iterations[allocations_constraints] == 0
+										&& n_allocations_further_iterations[allocations_residual_norm] == 0
+										&& n_allocations_further_iterations[allocations_update] == 0);
+			if (!allocation_free)
+			{
+				std::cout << " (expected 0 for CST, RES and UPD after the first iteration)";
+			}
+			Assert (allocation_free,
+					ExcMessage("Heap allocations in the constraints, the residual norm or the update"));
+		}
+		else
+		{
+			std::cout << " not counted (build with ENABLE_ALLOCATION_COUNTER on glibc)";
+		}
+		std::cout << std::endl;
+	}
+	std::cout << std::endl;
+}
+
+
+template <int dim>
+void Solid<dim>::get_error_residual(Errors &error_residual)
+{
+	/*This step is necessary if the entry of the vector
+	 at a constrained dof is not zero - this depends on 
+	 the way constraints are imposed; To be sure it is 
+	 safer to only consider the unconstrained entries anyway.
+	 The norm is summed up directly instead of copying them into a vector*/
+	double error_res_sqr = 0.0;
+	for (unsigned int i = 0; i < dof_handler_ref.n_dofs(); ++i)
+	{
+		if (!constraints.is_constrained(i))
+		{
+			error_res_sqr += system_rhs(i) * system_rhs(i);
+		}
+	}
+	error_residual.u = std::sqrt(error_res_sqr);
+}
+
+
+template <int dim>
+Vector<double>
+Solid<dim>::get_total_solution(const Vector<double> &solution_delta) const
+{
+	Vector<double> solution_total(solution_n);
+	solution_total += solution_delta;
+	return solution_total;
+}
+
+
+template <int dim>
+void Solid<dim>::get_total_solution(const Vector<double> &solution_delta,
+									Vector<double> &solution_total) const
+{
+	solution_total = solution_n;
+	solution_total += solution_delta;
+}
+
+
+template <int dim>
+double Solid<dim>::compute_potential_energy(const Vector<double> &solution_delta)
+{
+	get_total_solution(solution_delta, solution_total_trial);
+	const Vector<double> &current_solution = solution_total_trial;
+	const NeoHookeanMaterial<dim> material(this->mu, this->lambda);
+	const std::vector<unsigned int> &shape_component = reference_geometry.shape_component;
+	FEFaceValues<dim> &fe_face_values_ref = scratch_serial->fe_face_values_ref;
+	std::vector<types::global_dof_index> &local_dof_indices = per_task_data_serial.local_dof_indices;
+	std::vector<double> &local_solution = scratch_serial->local_solution;
+
+	double energy = 0.0;
+	typename DoFHandler<dim>::active_cell_iterator cell = dof_handler_ref.begin_active(),
+												endc = dof_handler_ref.end();
+	for(;cell!=endc;++cell)
+	{
+		cell->get_dof_indices(local_dof_indices);
+		for(unsigned int i=0; i<dofs_per_cell; ++i)
+		{
+			local_solution[i] = current_solution(local_dof_indices[i]);
+		}
+		const unsigned int cell_index = cell->active_cell_index();
+		for(unsigned int k=0; k<n_q_points; ++k)
+		{
+			const Tensor<1,dim> *shape_gradients_ref = reference_geometry.shape_gradients_at(cell_index, k);
+			Tensor<2,dim> DeformationGradient(Physics::Elasticity::StandardTensors<dim>::I);
+			for(unsigned int i=0; i<dofs_per_cell; ++i)
+			{
+				DeformationGradient[shape_component[i]] += local_solution[i] * shape_gradients_ref[i];
+			}
+			/*The energy is infinite for inadmissible deformations*/
+			if (determinant(DeformationGradient) <= 0.0)
+			{
+				return std::numeric_limits<double>::infinity();
+			}
+			energy += material.get_StrainEnergy(DeformationGradient) * reference_geometry.JxW(cell_index, k);
+		}
+
+		/*Work of the dead load on the Neumann boundary*/
+		for(unsigned int face=0; face < GeometryInfo<dim>::faces_per_cell && !precompute_external_load; ++face)
+		{
+			if(cell->face(face)->at_boundary() && cell->face(face)->boundary_id() == id_Neumann_boundary )
+			{
+				fe_face_values_ref.reinit(cell, face);
+				for(unsigned int f_q_point = 0; f_q_point < n_q_points_f; ++f_q_point)
+				{
+					const Tensor<1,dim> Traction = load_magnitude * load_fraction
+													* fe_face_values_ref.normal_vector(f_q_point);
+					for(unsigned int i = 0; i< dofs_per_cell; ++i)
+					{
+						energy -= local_solution[i] * (fe_face_values_ref[u_fe].value(i,f_q_point) * Traction)
+								* fe_face_values_ref.JxW(f_q_point);
+					}
+				}
+			}
+		}
+	}
+	/*With the precomputed external load the work is a single inner product; the total
+	 solution fulfils the constraints, i.e. the unconstrained vector gives the same*/
+	if (precompute_external_load)
+	{
+		energy -= load_magnitude * load_fraction * (external_load_unit_reference * current_solution);
+	}
+	return energy;
+}
+
+template <int dim>
+double Solid<dim>::line_search(const Vector<double> &solution_delta,
+								const Vector<double> &newton_update,
+								unsigned int &n_evaluations)
+{
+	/*Directional derivative of the energy at the current iterate; system_rhs holds the
+	 negative residual*/
+	const double slope_0 = -(newton_update * system_rhs);
+	n_evaluations = 0;
+	if (slope_0 >= 0.0)
+	{
+		/*Not a descent direction of the energy, e.g. for an indefinite tangent*/
+		return 1.0;
+	}
+	const double energy_0 = compute_potential_energy(solution_delta);
+	++n_evaluations;
+
+	/*Backtracking with the Armijo condition and quadratic interpolation of the energy*/
+	const double c_armijo = 1e-4;
+	double step_length = 1.0;
+	/*Evaluated step with the lowest energy and the last (smallest) evaluated step*/
+	double step_length_best = 1.0;
+	double energy_best = std::numeric_limits<double>::infinity();
+	double step_length_evaluated = 1.0;
+	while (n_evaluations < max_line_search_evaluations)
+	{
+		solution_delta_trial = solution_delta;
+		solution_delta_trial.add(step_length, newton_update);
+		const double energy = compute_potential_energy(solution_delta_trial);
+		++n_evaluations;
+		if (energy <= energy_0 + c_armijo * step_length * slope_0)
+		{
+			return step_length;
+		}
+		step_length_evaluated = step_length;
+		if (energy < energy_best)
+		{
+			energy_best = energy;
+			step_length_best = step_length;
+		}
+		double step_length_new = 0.5 * step_length;
+		if (std::isfinite(energy))
+		{
+			step_length_new = -slope_0 * step_length * step_length
+							/ (2.0 * (energy - energy_0 - slope_0 * step_length));
+		}
+		step_length = std::max(0.1 * step_length, std::min(step_length_new, 0.5 * step_length));
+	}
+	/*No step fulfilled the Armijo condition within max_line_search_evaluations: the last
+	 candidate was never evaluated, i.e. the evaluated step with the lowest energy is
+	 taken, or the smallest one if all of them were inadmissible (det F <= 0)*/
+	return (std::isfinite(energy_best) ? step_length_best : step_length_evaluated);
+}
+
+template <int dim>
+void Solid<dim>::make_constraints(const int &it_nr)
+{
+    std::cout << " CST " << std::flush;
+	/*Check the current number of newton iterations and decide based on 
+	 the discussion in the exercise after how many iterations you could 
+	 leave this function*/
+	//BEGIN - INSERT YOUR CODE HERE
+    if (it_nr >= 1)
+	{
+		return;
+	}
+	//END - INSERT YOUR CODE HERE
+
+	/*Clear and write hanging node and Dirichlet constraints into
+	 the affine_constraints constraints*/
+    constraints.clear();
+	DoFTools::make_hanging_node_constraints (dof_handler_ref,constraints);
+    const bool apply_dirichlet_bc = (it_nr == 0);
+	const FEValuesExtractors::Vector displacement(0);
+	const int boundary_id = id_Dirichlet_boundary;
+
+	/*if conditional to check which function should be used for the Dirichlet constraints*/
+	if (apply_dirichlet_bc == true)
+	{
+		VectorTools::interpolate_boundary_values(dof_handler_ref,
+												boundary_id,
+												ZeroFunction<dim>(dim),
+												constraints,
+												fe.component_mask(displacement));
+	}
+	else
+	{
+		VectorTools::interpolate_boundary_values(dof_handler_ref,
+												boundary_id,
+												ZeroFunction<dim>(dim),
+												constraints,
+												fe.component_mask(displacement));	
+	}
+    constraints.close();
+	if (precompute_external_load)
+	{
+		condense_external_load();
+	}
+	/*The MatrixFree data structures store the constraints, i.e. they
+	 have to be rebuilt together with them*/
+	if (mf_operator)
+	{
+		mf_operator->initialize(dof_handler_ref, constraints);
+	}
+}
+
+template <int dim>
+void Solid<dim>::assemble_system(const AssemblyType assembly_type)
+{
+	const bool assemble_rhs = (assembly_type != tangent_only);
+	/*The matrix-free operator is never assembled*/
+	const bool assemble_matrix = (assembly_type != residual_only
+								&& tangent_type != "MatrixFree");
+	if (!assemble_rhs && !assemble_matrix)
+	{
+		return;
+	}
+
+		std::cout << (assemble_matrix ? " Assemble System " : " Assemble Residual ") << std::flush;
+
+	//Compute the current, total solution, i.e. starting value of
+	//current load step and current solution_delta, into the vector the
+	//scratch objects read from
+	get_total_solution(this->solution_delta, solution_total);
+
+	//The dead load on the Neumann boundary is a scaled vector add, the faces are
+	//skipped by the workers
+	if (assemble_rhs && precompute_external_load)
+	{
+		system_rhs.add(load_magnitude * load_fraction, external_load_unit);
+	}
+
+	//The scratch objects with the FaceValues for the Neumann boundary are taken
+	//from the pools set up in system_setup(); the cell quantities are
+	//precomputed in reference_geometry.
+	//The copiers run one after another, i.e. they collect det F <= 0 of the
+	//workers without synchronisation
+	bool invalid_deformation = false;
+	if (vectorized_assembly)
+	{
+		for (PerTaskData_ASM &data : per_task_data_batch.cells)
+		{
+			data.assemble_rhs = assemble_rhs;
+			data.assemble_matrix = assemble_matrix;
+		}
+
+		auto worker = [this](const typename std::vector<CellBatch>::const_iterator &batch,
+							PooledScratchData &,
+							PerTaskData_Batch &data)
+		{
+			this->assemble_system_cell_batch(*batch, this->scratch_pool_batch->get(), data);
+		};
+		auto copier = [this, &invalid_deformation](const PerTaskData_Batch &data)
+		{
+			for (unsigned int l = 0; l < data.n_cells; ++l)
+			{
+				invalid_deformation = invalid_deformation || data.cells[l].invalid_deformation;
+				this->copy_local_to_global_ASM(data.cells[l]);
+			}
+		};
+
+		WorkStream::run(cell_batches.cbegin(),
+						cell_batches.cend(),
+						worker,
+						copier,
+						PooledScratchData(),
+						per_task_data_batch);
+		if (invalid_deformation)
+		{
+			throw StrainMeasures::InvalidDeformation();
+		}
+		return;
+	}
+
+	//The per-task data is still copied by WorkStream for its internal buffers
+	per_task_data.assemble_rhs = assemble_rhs;
+	per_task_data.assemble_matrix = assemble_matrix;
+
+	auto worker = [this](const typename DoFHandler<dim>::active_cell_iterator &cell,
+						PooledScratchData &,
+						PerTaskData_ASM &data)
+	{
+		this->assemble_system_one_cell(cell, this->scratch_pool->get(), data);
+	};
+	auto copier = [this, &invalid_deformation](const PerTaskData_ASM &data)
+	{
+		invalid_deformation = invalid_deformation || data.invalid_deformation;
+		this->copy_local_to_global_ASM(data);
+	};
+
+	WorkStream::run(dof_handler_ref.begin_active(),
+					dof_handler_ref.end(),
+					worker,
+					copier,
+					PooledScratchData(),
+					per_task_data);
+	if (invalid_deformation)
+	{
+		throw StrainMeasures::InvalidDeformation();
+	}
+}
+
+
+template <int dim>
+void Solid<dim>::assemble_residual(const Vector<double> &solution_delta_trial,
+									Vector<double> &residual)
+{
+	//The scratch objects of scratch_pool_residual read from solution_total_trial
+	get_total_solution(solution_delta_trial, solution_total_trial);
+	if (precompute_external_load)
+	{
+		residual.add(load_magnitude * load_fraction, external_load_unit);
+	}
+
+	auto worker = [this](const typename DoFHandler<dim>::active_cell_iterator &cell,
+						PooledScratchData &,
+						PerTaskData_ASM &data)
+	{
+		this->assemble_system_one_cell(cell, this->scratch_pool_residual->get(), data);
+	};
+	bool invalid_deformation = false;
+	auto copier = [this, &residual, &invalid_deformation](const PerTaskData_ASM &data)
+	{
+		invalid_deformation = invalid_deformation || data.invalid_deformation;
+		this->constraints.distribute_local_to_global(data.cell_rhs,
+													data.local_dof_indices,
+													residual);
+	};
+
+	WorkStream::run(dof_handler_ref.begin_active(),
+					dof_handler_ref.end(),
+					worker,
+					copier,
+					PooledScratchData(),
+					per_task_data_residual);
+	if (invalid_deformation)
+	{
+		throw StrainMeasures::InvalidDeformation();
+	}
+}
+
+
+template <int dim>
+void Solid<dim>::copy_local_to_global_ASM(const PerTaskData_ASM &data)
+{
+	if (tangent_type == "SparseSymmetric")
+	{
+		copy_local_to_global_ASM(data, tangent_matrix_sym);
+	}
+	else if (tangent_type == "BlockSparse")
+	{
+		copy_local_to_global_ASM(data, tangent_matrix_bsr);
+	}
+	else
+	{
+		copy_local_to_global_ASM(data, tangent_matrix);
+	}
+}
+
+
+template <int dim>
+template <typename MatrixType>
+void Solid<dim>::copy_local_to_global_ASM(const PerTaskData_ASM &data, MatrixType &matrix)
+{
+	//copy local to global
+	if (data.assemble_rhs && data.assemble_matrix)
+	{
+		constraints.distribute_local_to_global(data.cell_matrix,data.cell_rhs,
+								data.local_dof_indices,
+								matrix,system_rhs,false);
+	}
+	else if (data.assemble_rhs)
+	{
+		constraints.distribute_local_to_global(data.cell_rhs,
+								data.local_dof_indices,
+								system_rhs);
+	}
+	else
+	{
+		constraints.distribute_local_to_global(data.cell_matrix,
+								data.local_dof_indices,
+								matrix);
+	}
+}
+
+
+template <int dim>
+void Solid<dim>::reset_tangent()
+{
+	if (tangent_type == "SparseSymmetric")
+	{
+		tangent_matrix_sym = 0.0;
+	}
+	else if (tangent_type == "BlockSparse")
+	{
+		tangent_matrix_bsr = 0.0;
+	}
+	else if (tangent_type != "MatrixFree")
+	{
+		tangent_matrix = 0.0;
+	}
+}
+
+
+template <int dim>
+void Solid<dim>::assemble_system_one_cell(const typename DoFHandler<dim>::active_cell_iterator &cell,
+										ScratchData_ASM &scratch,
+										PerTaskData_ASM &data) const
+{
+	//Reset the local rhs and matrix for every cell
+	data.reset();
+	//Write the global indicies of the local dofs of the current cell
+	cell->get_dof_indices(data.local_dof_indices);
+	//Values of the current solution at the local dofs
+	for(unsigned int i=0; i<dofs_per_cell; ++i)
+	{
+		scratch.local_solution[i] = scratch.solution_total(data.local_dof_indices[i]);
+	}
+	const unsigned int cell_index = cell->active_cell_index();
+	//The material throws InvalidDeformation for det F <= 0, which must not leave the worker
+	try
+	{
+		(this->*cell_quadrature_kernel)(reference_geometry.shape_gradients_at(cell_index, 0),
+										&reference_geometry.JxW_values[std::size_t(cell_index) * n_q_points],
+										scratch,
+										data);
+	}
+	catch (const StrainMeasures::InvalidDeformation &)
+	{
+		data.invalid_deformation = true;
+		return;
+	}
+	assemble_neumann_faces(cell, scratch, data);
+}
+
+
+template <int dim>
+void Solid<dim>::assemble_neumann_faces(const typename DoFHandler<dim>::active_cell_iterator &cell,
+										ScratchData_ASM &scratch,
+										PerTaskData_ASM &data) const
+{
+	//The traction is added as external_load_unit by the callers of the workers instead
+	if (precompute_external_load)
+	{
+		return;
+	}
+	FEFaceValues<dim> &fe_face_values_ref = scratch.fe_face_values_ref;
+	Vector<double> &cell_rhs = data.cell_rhs;
+
+	//Check for Neumann boundary condition
+	for(unsigned int face=0; face < GeometryInfo<dim>::faces_per_cell && data.assemble_rhs; ++face)
+	{
+		if(cell->face(face)->at_boundary() && cell->face(face)->boundary_id() == id_Neumann_boundary )
+		{
+			fe_face_values_ref.reinit(cell, face);
+			
+			for(unsigned int f_q_point = 0; f_q_point < n_q_points_f; ++f_q_point)
+			{
+				double step_fraction = load_fraction;
+				double current_load = load_magnitude * step_fraction;
+				//Compute the following
+				//
+				//- The normal vector of the current face at the current quadrature point (fe_face_values_ref)
+				//- The normal vector scaled with "current_load"
+				const Tensor<1,dim> NormalVector = fe_face_values_ref.normal_vector(f_q_point);
+				const Tensor<1,dim> Traction = current_load  * NormalVector;					
+
+				for(unsigned int i = 0; i< dofs_per_cell; ++i)
+				{
+					//Compute
+					//
+					//- the test function at the face quadrature point for the i-th test function
+					//- write into cell_rhs(i)+= the contribution due to the Neumann boundary condition (-=(-))->+=
+					//!! Don't forget the JxW value of that face!!
+					const Tensor<1,dim> shape_function = fe_face_values_ref[u_fe].value(i,f_q_point);
+					cell_rhs(i)+= (shape_function * Traction) * fe_face_values_ref.JxW(f_q_point);
+				}
+			}
+		}
+	}
+}
+
+
+template <int dim>
+void Solid<dim>::assemble_cell_quadrature(const Tensor<1,dim> *cell_shape_gradients_ref,
+										const double *JxW_values,
+										ScratchData_ASM &scratch,
+										PerTaskData_ASM &data) const
+{
+	NeoHookeanMaterial<dim> material(this->mu, this->lambda);
+
+	FullMatrix<double> &cell_matrix = data.cell_matrix;
+	Vector<double> &cell_rhs = data.cell_rhs;
+	std::vector<Tensor<2,dim> > &shape_gradients_spt = scratch.shape_gradients_spt;
+	std::vector<SymmetricTensor<2,dim> > &sym_shape_gradients_spt = scratch.sym_shape_gradients_spt;
+	const std::vector<unsigned int> &shape_component = reference_geometry.shape_component;
+
+	//Loop over all quadrature points of the cell
+	for(unsigned int k=0; k<n_q_points;++k)
+	{
+		//Reference gradients of all shape functions at the current quadrature point
+		const Tensor<1,dim> *shape_gradients_ref = cell_shape_gradients_ref + std::size_t(k) * dofs_per_cell;
+		//Gradient of the solution at the current quadrature point
+		Tensor<2,dim> solution_grad_u;
+		for(unsigned int i=0; i<dofs_per_cell; ++i)
+		{
+			solution_grad_u[shape_component[i]] += scratch.local_solution[i] * shape_gradients_ref[i];
+		}
+
+		//- deformation gradient using the information in "solution_grad_u" and Physics::Elasticity::StandardTensors<dim>::I
+		//- use the deformation gradient to compute Kirchhoffstress, Tangent and
+		//  the inverse of the Deformation gradient in one evaluation of the material
+		Tensor<2,dim> DeformationGradient =  (Tensor<2, dim>(Physics::Elasticity::StandardTensors<dim>::I) + solution_grad_u);
+		material.evaluate(DeformationGradient, scratch.material_point,
+						data.assemble_matrix && !NeoHookeanMaterial<dim>::has_isotropic_tangent);
+		const SymmetricTensor<2,dim> &Kirchhoffstress = scratch.material_point.KirchhoffStress;
+		const Tensor<2,dim> &F_inv = scratch.material_point.F_inv;
+		
+		//The quadrature weight for the current quadrature point
+		const double JxW = JxW_values[k];
+
+		//The gradients with respect to the spatial configuration are computed once
+		//per shape function and not again inside the loop over j
+		for(unsigned int i=0; i<dofs_per_cell; ++i)
+		{
+			//The gradient of the vector valued shape function has one nonzero row
+			Tensor<2,dim> shape_gradient_wrt_ref_config_i;
+			shape_gradient_wrt_ref_config_i[shape_component[i]] = shape_gradients_ref[i];
+			shape_gradients_spt[i] = shape_gradient_wrt_ref_config_i * F_inv;
+			sym_shape_gradients_spt[i] = symmetrize(shape_gradients_spt[i]);
+		}
+
+		//Loop over all dof's of the cell
+		for(unsigned int i=0; i<dofs_per_cell; ++i)
+		{
+			//Assemble system_rhs contribution and the upper triangle (j >= i) of the
+			//symmetric cell_matrix
+			//  !! "-=" due to Newton-Raphson algorithm K\du = -r
+			if (data.assemble_rhs)
+			{
+				cell_rhs(i)-= (sym_shape_gradients_spt[i] * Kirchhoffstress) * JxW;
+			}
+
+			if (!data.assemble_matrix)
+			{
+				continue;
+			}
+			if (NeoHookeanMaterial<dim>::has_isotropic_tangent)
+			{
+				//The material contribution of a tangent a*IxI + b*S is evaluated in
+				//closed form as a*tr(eps_i)*tr(eps_j) + b*(eps_i:eps_j)
+				const IsotropicTangent<dim> &Tangent = scratch.material_point.Tangent_iso;
+				for(unsigned int j=i; j<dofs_per_cell; ++j)
+				{
+					cell_matrix(i,j) += (( symmetrize (transpose(shape_gradients_spt[i]) * 
+											shape_gradients_spt[j]) * Kirchhoffstress ) //geometrical contribution
+										+ Tangent.contract(sym_shape_gradients_spt[i], // The material contribution:
+															sym_shape_gradients_spt[j]) )
+										* JxW;
+				}
+			}
+			else
+			{
+				//Generic material contribution for tangents without that structure
+				const SymmetricTensor<4,dim> &Tangent = scratch.material_point.Tangent_spt;
+				for(unsigned int j=i; j<dofs_per_cell; ++j)
+				{
+					//Assemble tangent contribution: material and geometrical contributions
+					cell_matrix(i,j) += (( symmetrize (transpose(shape_gradients_spt[i]) * 
+											shape_gradients_spt[j]) * Kirchhoffstress ) //geometrical contribution
+										+ (sym_shape_gradients_spt[i] * Tangent // The material contribution:
+											* sym_shape_gradients_spt[j]) )
+										* JxW;		
+				}
+			}
+		}
+	}
+
+	//The lower triangle follows from symmetry
+	if (data.assemble_matrix)
+	{
+		for(unsigned int i=0; i<dofs_per_cell; ++i)
+			for(unsigned int j=0; j<i; ++j)
+			{
+				cell_matrix(i,j) = cell_matrix(j,i);
+			}
+	}
+}
+
+
+template <int dim>
+template <int fe_degree>
+void Solid<dim>::assemble_cell_quadrature_fixed(const Tensor<1,dim> *cell_shape_gradients_ref,
+												const double *JxW_values,
+												ScratchData_ASM &scratch,
+												PerTaskData_ASM &data) const
+{
+	constexpr unsigned int n_nodes_1d = fe_degree + 1;
+	constexpr unsigned int n_dofs = dim * (dim == 2 ? n_nodes_1d * n_nodes_1d
+											: n_nodes_1d * n_nodes_1d * n_nodes_1d);
+	//Two Gauss points per direction, see qf_cell
+	constexpr unsigned int n_q = (dim == 2 ? 4 : 8);
+	Assert (dofs_per_cell == n_dofs && n_q_points == n_q,
+			ExcMessage("Fixed-size kernel instantiated for another degree or quadrature"));
+	static_assert (NeoHookeanMaterial<dim>::has_isotropic_tangent,
+					"The fixed-size kernel contracts the tangent in its isotropic form");
+
+	NeoHookeanMaterial<dim> material(this->mu, this->lambda);
+	const std::vector<unsigned int> &shape_component = reference_geometry.shape_component;
+	const double *local_solution = scratch.local_solution.data();
+
+	std::array<Tensor<2,dim>, n_dofs>          shape_gradients_spt;
+	std::array<SymmetricTensor<2,dim>, n_dofs> sym_shape_gradients_spt;
+	//The contributions go directly into the storage of the local matrix and rhs (reset
+	//by the caller), rows of the matrix with the compile-time stride n_dofs. Only the
+	//upper triangle is computed, the lower one follows from symmetry
+	double *const cell_matrix = (data.assemble_matrix ? &data.cell_matrix(0,0) : nullptr);
+	double *const cell_rhs = data.cell_rhs.begin();
+
+	for(unsigned int k=0; k<n_q;++k)
+	{
+		const Tensor<1,dim> *shape_gradients_ref = cell_shape_gradients_ref + std::size_t(k) * n_dofs;
+		Tensor<2,dim> DeformationGradient(Physics::Elasticity::StandardTensors<dim>::I);
+		for(unsigned int i=0; i<n_dofs; ++i)
+		{
+			DeformationGradient[shape_component[i]] += local_solution[i] * shape_gradients_ref[i];
+		}
+		material.evaluate(DeformationGradient, scratch.material_point, false);
+		const SymmetricTensor<2,dim> &Kirchhoffstress = scratch.material_point.KirchhoffStress;
+		const IsotropicTangent<dim> &Tangent = scratch.material_point.Tangent_iso;
+		const Tensor<2,dim> &F_inv = scratch.material_point.F_inv;
+		const double JxW = JxW_values[k];
+
+		for(unsigned int i=0; i<n_dofs; ++i)
+		{
+			//Only row shape_component[i] of the reference gradient is nonzero
+			for(unsigned int d=0; d<dim; ++d)
+			{
+				shape_gradients_spt[i][d] = (d == shape_component[i] ? shape_gradients_ref[i] * F_inv
+																	: Tensor<1,dim>());
+			}
+			sym_shape_gradients_spt[i] = symmetrize(shape_gradients_spt[i]);
+		}
+
+		for(unsigned int i=0; i<n_dofs; ++i)
+		{
+			if (data.assemble_rhs)
+			{
+				cell_rhs[i] -= (sym_shape_gradients_spt[i] * Kirchhoffstress) * JxW;
+			}
+			if (!data.assemble_matrix)
+			{
+				continue;
+			}
+			for(unsigned int j=i; j<n_dofs; ++j)
+			{
+				cell_matrix[i*n_dofs + j] += (( symmetrize (transpose(shape_gradients_spt[i]) *
+												shape_gradients_spt[j]) * Kirchhoffstress ) //geometrical contribution
+									+ Tangent.contract(sym_shape_gradients_spt[i], //material contribution
+														sym_shape_gradients_spt[j]) )
+									* JxW;
+			}
+		}
+	}
+
+	if (data.assemble_matrix)
+	{
+		for(unsigned int i=0; i<n_dofs; ++i)
+			for(unsigned int j=0; j<i; ++j)
+			{
+				cell_matrix[i*n_dofs + j] = cell_matrix[j*n_dofs + i];
+			}
+	}
+}
+
+
+template <int dim>
+void Solid<dim>::assemble_cell_quadrature_voigt(const Tensor<1,dim> *cell_shape_gradients_ref,
+												const double *JxW_values,
+												ScratchData_ASM &scratch,
+												PerTaskData_ASM &data) const
+{
+	const unsigned int n_voigt = SymmetricTensor<2,dim>::n_independent_components;
+	NeoHookeanMaterial<dim> material(this->mu, this->lambda);
+	const std::vector<unsigned int> &shape_component = reference_geometry.shape_component;
+	FullMatrix<double> &M = scratch.element_matrix_M;
+	FullMatrix<double> &WM = scratch.weighted_element_matrix_M;
+	FullMatrix<double> &W = scratch.weight_matrix;
+
+	for(unsigned int k=0; k<n_q_points;++k)
+	{
+		const Tensor<1,dim> *shape_gradients_ref = cell_shape_gradients_ref + std::size_t(k) * dofs_per_cell;
+		Tensor<2,dim> DeformationGradient(Physics::Elasticity::StandardTensors<dim>::I);
+		for(unsigned int i=0; i<dofs_per_cell; ++i)
+		{
+			DeformationGradient[shape_component[i]] += scratch.local_solution[i] * shape_gradients_ref[i];
+		}
+		material.evaluate(DeformationGradient, scratch.material_point, data.assemble_matrix);
+		const SymmetricTensor<2,dim> &Kirchhoffstress = scratch.material_point.KirchhoffStress;
+		const Tensor<2,dim> &F_inv = scratch.material_point.F_inv;
+		const double JxW = JxW_values[k];
+
+		//Column i of M: the strain of shape function i in Voigt notation (shear
+		//components doubled) followed by its spatial gradient row by row. The
+		//gradient of shape function i is e_c x h with c = shape_component[i]
+		for(unsigned int i=0; i<dofs_per_cell; ++i)
+		{
+			const unsigned int c = shape_component[i];
+			const Tensor<1,dim> h = shape_gradients_ref[i] * F_inv;
+			for(unsigned int I=0; I<n_voigt; ++I)
+			{
+				const TableIndices<2> ab = SymmetricTensor<2,dim>::unrolled_to_component_indices(I);
+				M(I,i) = (ab[0] == ab[1] ? (ab[0] == c ? h[c] : 0.)
+						: (ab[0] == c ? h[ab[1]] : 0.) + (ab[1] == c ? h[ab[0]] : 0.));
+			}
+			for(unsigned int r=0; r<dim*dim; ++r)
+			{
+				M(n_voigt + r, i) = (r / dim == c ? h[r % dim] : 0.);
+			}
+		}
+
+		//  !! "-=" due to Newton-Raphson algorithm K\du = -r; B^T tau in Voigt notation
+		if (data.assemble_rhs)
+		{
+			for(unsigned int i=0; i<dofs_per_cell; ++i)
+				for(unsigned int I=0; I<n_voigt; ++I)
+				{
+					const TableIndices<2> ab = SymmetricTensor<2,dim>::unrolled_to_component_indices(I);
+					data.cell_rhs(i) -= M(I,i) * Kirchhoffstress[ab[0]][ab[1]] * JxW;
+				}
+		}
+		if (!data.assemble_matrix)
+		{
+			continue;
+		}
+
+		//W = diag(D, Sigma) * JxW with D_IJ = c_abcd and Sigma_(ka)(lb) = delta_kl tau_ab
+		const SymmetricTensor<4,dim> &Tangent = scratch.material_point.Tangent_spt;
+		W = 0.;
+		for(unsigned int I=0; I<n_voigt; ++I)
+		{
+			const TableIndices<2> ab = SymmetricTensor<2,dim>::unrolled_to_component_indices(I);
+			for(unsigned int J=0; J<n_voigt; ++J)
+			{
+				const TableIndices<2> cd = SymmetricTensor<2,dim>::unrolled_to_component_indices(J);
+				W(I,J) = Tangent[ab[0]][ab[1]][cd[0]][cd[1]] * JxW;
+			}
+		}
+		for(unsigned int k_c=0; k_c<dim; ++k_c)
+			for(unsigned int a=0; a<dim; ++a)
+				for(unsigned int b=0; b<dim; ++b)
+				{
+					W(n_voigt + k_c*dim + a, n_voigt + k_c*dim + b) = Kirchhoffstress[a][b] * JxW;
+				}
+
+		//K += M^T (W M), material (B^T D B) and geometrical (G^T Sigma G) contribution at once
+		W.mmult(WM, M);
+		M.Tmmult(data.cell_matrix, WM, true);
+	}
+}
+
+
+template <int dim>
+void Solid<dim>::select_cell_quadrature_kernel()
+{
+	AssertThrow (kernel_type == "Runtime" || kernel_type == "FixedSize" || kernel_type == "Voigt",
+				ExcMessage("Kernel type " + kernel_type + " not implemented"));
+	cell_quadrature_kernel = &Solid<dim>::assemble_cell_quadrature;
+	if (kernel_type == "Voigt")
+	{
+		cell_quadrature_kernel = &Solid<dim>::assemble_cell_quadrature_voigt;
+		return;
+	}
+	if (kernel_type == "Runtime" || n_q_points_1d != 2)
+	{
+		return;
+	}
+	switch (degree)
+	{
+		case 1:
+			cell_quadrature_kernel = &Solid<dim>::template assemble_cell_quadrature_fixed<1>;
+			break;
+		case 2:
+			cell_quadrature_kernel = &Solid<dim>::template assemble_cell_quadrature_fixed<2>;
+			break;
+		case 3:
+			cell_quadrature_kernel = &Solid<dim>::template assemble_cell_quadrature_fixed<3>;
+			break;
+		case 4:
+			cell_quadrature_kernel = &Solid<dim>::template assemble_cell_quadrature_fixed<4>;
+			break;
+		default:
+			break;
+	}
+}
+
+
+template <int dim>
+void Solid<dim>::benchmark_cell_kernels()
+{
+	AssertThrow (tangent_type == "Sparse",
+				ExcMessage("The kernel benchmark needs the tangent_type Sparse"));
+	const unsigned int n_repetitions = 5;
+	make_grid();
+	system_setup();
+	make_constraints(0);
+
+	const std::string kernel_type_selected = kernel_type;
+	const std::vector<std::string> kernel_types = {"Runtime", "FixedSize", "Voigt"};
+	std::vector<double> times;
+	std::vector<SparseMatrix<double> > matrices(kernel_types.size());
+	bool fixed_size_instantiated = true;
+	for (unsigned int t = 0; t < kernel_types.size(); ++t)
+	{
+		kernel_type = kernel_types[t];
+		select_cell_quadrature_kernel();
+		if (kernel_type == "FixedSize")
+		{
+			fixed_size_instantiated = (cell_quadrature_kernel != &Solid<dim>::assemble_cell_quadrature);
+		}
+		Timer timer;
+		for (unsigned int r = 0; r < n_repetitions; ++r)
+		{
+			reset_tangent();
+			system_rhs = 0.0;
+			assemble_system();
+		}
+		times.push_back(timer.wall_time() / n_repetitions);
+		matrices[t].reinit(sparsity_pattern);
+		matrices[t].copy_from(tangent_matrix);
+	}
+	kernel_type = kernel_type_selected;
+	select_cell_quadrature_kernel();
+
+	std::cout << "\nCell kernels, degree " << degree << " (" << dofs_per_cell << " dofs per cell, "
+			<< triangulation.n_active_cells() << " cells, mean of " << n_repetitions << " assemblies)"
+			<< (fixed_size_instantiated ? "" : ", FixedSize not instantiated: runtime kernel used")
+			<< std::endl;
+	std::cout << "  KERNEL      WALL_TIME[s]   SPEEDUP   DIFFERENCE" << std::endl;
+	for (unsigned int t = 0; t < kernel_types.size(); ++t)
+	{
+		//l-infinity norm of the difference to the tangent of the runtime kernel
+		if (t > 0)
+		{
+			matrices[t].add(-1.0, matrices[0]);
+		}
+		std::cout << "  " << std::left << std::setw(10) << kernel_types[t] << std::right
+				<< "  " << std::scientific << std::setprecision(3) << std::setw(12) << times[t]
+				<< "   " << std::fixed << std::setprecision(2) << std::setw(7) << times[0] / times[t]
+				<< "   " << std::scientific << std::setprecision(2) << std::setw(10)
+				<< (t > 0 ? matrices[t].linfty_norm() : 0.) << std::endl;
+	}
+}
+
+
+template <int dim>
+void Solid<dim>::assemble_system_cell_batch(const CellBatch &cells,
+											ScratchData_Batch &scratch,
+											PerTaskData_Batch &data) const
+{
+	typedef VectorizedArray<double> VectorizedDouble;
+	static_assert(NeoHookeanMaterial<dim, VectorizedDouble>::has_isotropic_tangent,
+				"The vectorized assembly uses the isotropic form of the tangent");
+	const unsigned int n_lanes = VectorizedDouble::n_array_elements;
+	const NeoHookeanMaterial<dim, VectorizedDouble> material(this->mu, this->lambda);
+	const VectorizedDouble one = StrainMeasures::make_number<VectorizedDouble>(1.);
+	const std::vector<unsigned int> &shape_component = reference_geometry.shape_component;
+	const bool assemble_rhs = data.cells[0].assemble_rhs;
+	const bool assemble_matrix = data.cells[0].assemble_matrix;
+
+	//Gather the local solutions of the cells into the lanes. The empty lanes of the last
+	//batch repeat the geometry of its first cell with a zero solution, i.e. F = I
+	data.n_cells = cells.size();
+	const unsigned int valid_lanes = (1U << data.n_cells) - 1;
+	std::array<unsigned int, VectorizedDouble::n_array_elements> cell_indices;
+	for (unsigned int l = 0; l < n_lanes; ++l)
+	{
+		if (l < data.n_cells)
+		{
+			data.cells[l].reset();
+			cells[l]->get_dof_indices(data.cells[l].local_dof_indices);
+			cell_indices[l] = cells[l]->active_cell_index();
+		}
+		else
+		{
+			cell_indices[l] = cell_indices[0];
+		}
+		for(unsigned int i=0; i<dofs_per_cell; ++i)
+		{
+			scratch.local_solution[i][l] = (l < data.n_cells
+											? scratch.cell.solution_total(data.cells[l].local_dof_indices[i])
+											: 0.);
+		}
+	}
+	for(unsigned int i=0; i<dofs_per_cell; ++i)
+	{
+		scratch.cell_rhs[i] = 0.;
+		for(unsigned int j=i; j<dofs_per_cell; ++j)
+		{
+			scratch.cell_matrix[i*dofs_per_cell + j] = 0.;
+		}
+	}
+
+	//Same quadrature as assemble_cell_quadrature, with one cell per lane
+	for(unsigned int k=0; k<n_q_points;++k)
+	{
+		VectorizedDouble JxW;
+		for (unsigned int l = 0; l < n_lanes; ++l)
+		{
+			JxW[l] = reference_geometry.JxW(cell_indices[l], k);
+			const Tensor<1,dim> *shape_gradients_ref = reference_geometry.shape_gradients_at(cell_indices[l], k);
+			for(unsigned int i=0; i<dofs_per_cell; ++i)
+				for(unsigned int d=0; d<dim; ++d)
+				{
+					scratch.shape_gradients_ref[i][d][l] = shape_gradients_ref[i][d];
+				}
+		}
+
+		Tensor<2,dim,VectorizedDouble> DeformationGradient;
+		for(unsigned int i=0; i<dofs_per_cell; ++i)
+		{
+			DeformationGradient[shape_component[i]] += scratch.local_solution[i] * scratch.shape_gradients_ref[i];
+		}
+		for(unsigned int d=0; d<dim; ++d)
+		{
+			DeformationGradient[d][d] += one;
+		}
+		typename NeoHookeanMaterial<dim, VectorizedDouble>::Evaluation material_point;
+		material.evaluate(DeformationGradient, material_point, false);
+		//Lane-wise check of J > 0, the empty lanes hold F = I. The cells are only
+		//marked, the caller of the WorkStream throws
+		if ((material_point.invalid_lanes & valid_lanes) != 0)
+		{
+			for (unsigned int l = 0; l < data.n_cells; ++l)
+			{
+				data.cells[l].invalid_deformation = ((material_point.invalid_lanes >> l) & 1U);
+			}
+			return;
+		}
+		const SymmetricTensor<2,dim,VectorizedDouble> &Kirchhoffstress = material_point.KirchhoffStress;
+		const IsotropicTangent<dim,VectorizedDouble> &Tangent = material_point.Tangent_iso;
+
+		for(unsigned int i=0; i<dofs_per_cell; ++i)
+		{
+			Tensor<2,dim,VectorizedDouble> shape_gradient_wrt_ref_config_i;
+			shape_gradient_wrt_ref_config_i[shape_component[i]] = scratch.shape_gradients_ref[i];
+			scratch.shape_gradients_spt[i] = shape_gradient_wrt_ref_config_i * material_point.F_inv;
+			scratch.sym_shape_gradients_spt[i] = symmetrize(scratch.shape_gradients_spt[i]);
+		}
+
+		for(unsigned int i=0; i<dofs_per_cell; ++i)
+		{
+			if (assemble_rhs)
+			{
+				scratch.cell_rhs[i] -= (scratch.sym_shape_gradients_spt[i] * Kirchhoffstress) * JxW;
+			}
+			if (!assemble_matrix)
+			{
+				continue;
+			}
+			for(unsigned int j=i; j<dofs_per_cell; ++j)
+			{
+				scratch.cell_matrix[i*dofs_per_cell + j] +=
+					(( symmetrize (transpose(scratch.shape_gradients_spt[i]) *
+									scratch.shape_gradients_spt[j]) * Kirchhoffstress ) //geometrical contribution
+					+ Tangent.contract(scratch.sym_shape_gradients_spt[i], //material contribution
+										scratch.sym_shape_gradients_spt[j]) )
+					* JxW;
+			}
+		}
+	}
+
+	//Scatter the lanes into the local contributions of the cells
+	for (unsigned int l = 0; l < data.n_cells; ++l)
+	{
+		PerTaskData_ASM &cell_data = data.cells[l];
+		for(unsigned int i=0; i<dofs_per_cell; ++i)
+		{
+			cell_data.cell_rhs(i) = scratch.cell_rhs[i][l];
+			for(unsigned int j=i; j<dofs_per_cell && assemble_matrix; ++j)
+			{
+				cell_data.cell_matrix(i,j) = cell_data.cell_matrix(j,i) = scratch.cell_matrix[i*dofs_per_cell + j][l];
+			}
+		}
+		assemble_neumann_faces(cells[l], scratch.cell, cell_data);
 	}
-	std::cout << std::endl;
+}
 
-	std::cout << "           SOLVER STEP            "
-				<< " |  LIN_IT   LIN_RES    RES_NORM    "
-				<< std::endl;
 
-	for (unsigned int i = 0; i < l_width; ++i)
+template <int dim>
+void Solid<dim>::print_assembly_scaling()
+{
+	const unsigned int max_threads = MultithreadInfo::n_cores();
+	const unsigned int n_repetitions = 3;
+	//The constraints are needed to copy the local contributions into the global system
+	make_constraints(0);
+
+	std::cout << "\nAssembly scaling (mean of " << n_repetitions
+			<< " assemblies, " << triangulation.n_active_cells() << " cells):" << std::endl;
+
+	std::vector<std::pair<unsigned int, double> > timings;
+	for (unsigned int n_threads = 1; ; n_threads = std::min(2*n_threads, max_threads))
 	{
-		std::cout << "_";
+		MultithreadInfo::set_thread_limit(n_threads);
+		Timer timer;
+		for (unsigned int r = 0; r < n_repetitions; ++r)
+		{
+			reset_tangent();
+			system_rhs = 0.0;
+			assemble_system();
+		}
+		timer.stop();
+		timings.push_back(std::make_pair(n_threads, timer.wall_time()/n_repetitions));
+		if (n_threads >= max_threads)
+		{
+			break;
+		}
 	}
 	std::cout << std::endl;
+
+	const double time_serial = timings.front().second;
+	std::cout << "  THREADS   WALL_TIME[s]   SPEEDUP   EFFICIENCY" << std::endl;
+	for (const auto &timing : timings)
+	{
+		const double speedup = time_serial / timing.second;
+		std::cout << "  " << std::setw(7) << timing.first
+				<< "   " << std::scientific << std::setprecision(3) << std::setw(12) << timing.second
+				<< "   " << std::fixed << std::setprecision(2) << std::setw(7) << speedup
+				<< "   " << std::setw(10) << speedup / timing.first << std::endl;
+	}
+
+	//Restore the thread limit of the actual computation and clean the global system
+	MultithreadInfo::set_thread_limit(number_threads > 0 ? number_threads
+							: numbers::invalid_unsigned_int);
+	reset_tangent();
+	system_rhs = 0.0;
 }
 
 template <int dim>
-void Solid<dim>::print_conv_footer()
+void Solid<dim>::print_renumbering_comparison()
 {
-	const unsigned int l_width = 90;
-	for (unsigned int i = 0; i < l_width; ++i)
+	AssertThrow (tangent_type == "Sparse",
+				ExcMessage("The renumbering comparison needs the tangent_type Sparse"));
+	const std::string renumbering_type_selected = renumbering_type;
+	const std::vector<std::string> renumbering_types = {"None", "CuthillMcKee", "ReverseCuthillMcKee",
+														"King", "MinimumDegree", "ComponentWise",
+														"BlockWise", "Hierarchical", "SpaceFillingCurve", "Random"};
+	const unsigned int n_repetitions_spmv = 100;
+	const unsigned int n_repetitions_assembly = 3;
+
+	struct Metrics
 	{
-		std::cout << "_";
+		std::size_t bandwidth;
+		std::size_t profile;
+		double time_spmv;
+		double time_assembly;
+	};
+	std::vector<Metrics> metrics;
+	for (const std::string &type : renumbering_types)
+	{
+		renumbering_type = type;
+		setup_dofs();
+		if (precompute_external_load)
+		{
+			setup_external_load();
+		}
+		setup_sparsity_pattern();
+		make_constraints(0);
+
+		Metrics metric;
+		metric.bandwidth = sparsity_pattern.bandwidth();
+		/*Sum of the distances of the first entry of every row to the diagonal*/
+		metric.profile = 0;
+		for (unsigned int row = 0; row < sparsity_pattern.n_rows(); ++row)
+		{
+			std::size_t first_column = row;
+			for (auto entry = sparsity_pattern.begin(row); entry != sparsity_pattern.end(row); ++entry)
+			{
+				first_column = std::min<std::size_t>(first_column, entry->column());
+			}
+			metric.profile += row - first_column;
+		}
+
+		Timer timer;
+		for (unsigned int r = 0; r < n_repetitions_assembly; ++r)
+		{
+			reset_tangent();
+			system_rhs = 0.0;
+			assemble_system();
+		}
+		metric.time_assembly = timer.wall_time() / n_repetitions_assembly;
+
+		Vector<double> src(dof_handler_ref.n_dofs());
+		Vector<double> dst(dof_handler_ref.n_dofs());
+		for (unsigned int i = 0; i < src.size(); ++i)
+		{
+			src(i) = 1.0 + (i % 7);
+		}
+		timer.restart();
+		for (unsigned int r = 0; r < n_repetitions_spmv; ++r)
+		{
+			tangent_matrix.vmult(dst, src);
+		}
+		metric.time_spmv = timer.wall_time() / n_repetitions_spmv;
+		metrics.push_back(metric);
+	}
+
+	std::cout << "\nDoF renumbering (" << dof_handler_ref.n_dofs() << " dofs, SpMV mean of "
+			<< n_repetitions_spmv << ", assembly mean of " << n_repetitions_assembly << "):" << std::endl;
+	std::cout << "  RENUMBERING           BANDWIDTH      PROFILE      SPMV[s]   ASSEMBLY[s]" << std::endl;
+	for (unsigned int i = 0; i < renumbering_types.size(); ++i)
+	{
+		std::cout << "  " << std::left << std::setw(20) << renumbering_types[i] << std::right
+				<< "  " << std::setw(9) << metrics[i].bandwidth
+				<< "  " << std::setw(11) << metrics[i].profile
+				<< "  " << std::scientific << std::setprecision(3) << std::setw(11) << metrics[i].time_spmv
+				<< "  " << std::setw(12) << metrics[i].time_assembly << std::endl;
 	}
 	std::cout << std::endl;
 
-	std::cout << "Errors:" << std::endl
-				<< "Rhs: \t\t" << error_residual.u << std::endl
-				<< std::endl;
+	//Number the dofs for the actual computation again; the reference geometry, the work
+	//vectors and the scratch objects do not depend on the numbering
+	renumbering_type = renumbering_type_selected;
+	setup_dofs();
+	if (precompute_external_load)
+	{
+		setup_external_load();
+	}
+	setup_sparsity_pattern();
+	if (preconditioner_type == "Multigrid")
+	{
+		multigrid.initialize(dof_handler_ref, {types::boundary_id(id_Dirichlet_boundary)});
+	}
+	system_rhs = 0.0;
 }
 
-
 template <int dim>
-void Solid<dim>::get_error_residual(Errors &error_residual)
+void Solid<dim>::setup_preconditioner()
 {
-	/*This step is necessary if the entry of the vector
-	 at a constrained dof is not zero - this depends on 
-	 the way constraints are imposed; To be sure it is 
-	 safer to only consider the unconstrained entries anyway*/
-	Vector<double> error_res(dof_handler_ref.n_dofs());
-	for (unsigned int i = 0; i < dof_handler_ref.n_dofs(); ++i)
+	if (tangent_type == "MatrixFree")
 	{
-		if (!constraints.is_constrained(i))
+		/*The only information about the operator available without assembling it
+		 is its diagonal*/
+		mf_operator->compute_diagonal();
+		if (!preconditioner_jacobi)
 		{
-			error_res(i) = system_rhs(i);
+			preconditioner_jacobi = std::make_shared<DiagonalMatrix<Vector<double> > >();
 		}
+		preconditioner_jacobi->get_vector() = mf_operator->get_diagonal();
+		for (double &entry : preconditioner_jacobi->get_vector())
+		{
+			entry = (std::abs(entry) > 1e-14 ? 1.0 / entry : 1.0);
+		}
+
+		if (preconditioner_type == "Chebyshev")
+		{
+			typedef PreconditionChebyshev<NeoHookeanOperatorBase<dim>, Vector<double> > PreconditionerType;
+			typename PreconditionerType::AdditionalData additional_data;
+			additional_data.degree = chebyshev_degree;
+			additional_data.smoothing_range = 100.;
+			additional_data.eig_cg_n_iterations = 20;
+			additional_data.preconditioner = preconditioner_jacobi;
+			preconditioner_chebyshev.reset(new PreconditionerType());
+			preconditioner_chebyshev->initialize(*mf_operator, additional_data);
+		}
+		else
+		{
+			AssertThrow (preconditioner_type == "Jacobi",
+						ExcMessage("Preconditioner " + preconditioner_type
+									+ " needs an assembled tangent, use Jacobi or Chebyshev"));
+		}
+	}
+	else if (tangent_type == "SparseSymmetric")
+	{
+		preconditioner_ssor_sym.initialize(tangent_matrix_sym, 1.2);
+	}
+	else if (tangent_type == "BlockSparse")
+	{
+		preconditioner_ssor_bsr.initialize(tangent_matrix_bsr, 1.2);
+	}
+	else if (preconditioner_type == "Multigrid")
+	{
+		AssertThrow (tangent_type == "Sparse",
+					ExcMessage("The multigrid preconditioner needs the tangent_type Sparse"));
+		assemble_multigrid_matrices();
+	}
+	else
+	{
+		preconditioner_ssor.initialize(tangent_matrix, 1.2);
 	}
-	error_residual.u = error_res.l2_norm();
 }
 
 
 template <int dim>
-Vector<double>
-Solid<dim>::get_total_solution(const Vector<double> &solution_delta) const
+bool Solid<dim>::uses_preconditioner_policy() const
 {
-	Vector<double> solution_total(solution_n);
-	solution_total += solution_delta;
-	return solution_total;
+	return (solver_type == "Direct" || preconditioner_type == "Multigrid" || preconditioner_type == "Chebyshev");
 }
 
 
 template <int dim>
-void Solid<dim>::make_constraints(const int &it_nr)
+template <typename SolverType, typename MatrixType>
+void Solid<dim>::solve_preconditioned(SolverType &solver,
+									const MatrixType &matrix,
+									Vector<double> &newton_update,
+									const Vector<double> &rhs)
 {
-    std::cout << " CST " << std::flush;
-	/*Check the current number of newton iterations and decide based on 
-	 the discussion in the exercise after how many iterations you could 
-	 leave this function*/
-	//BEGIN - INSERT YOUR CODE HERE
-    if (it_nr >= 1)
+	if (tangent_type == "MatrixFree")
 	{
-		return;
+		if (preconditioner_type == "Jacobi")
+		{
+			solver.solve(matrix, newton_update, rhs, *preconditioner_jacobi);
+		}
+		else
+		{
+			solver.solve(matrix, newton_update, rhs, *preconditioner_chebyshev);
+		}
 	}
-	//END - INSERT YOUR CODE HERE
+	else if (tangent_type == "SparseSymmetric")
+	{
+		solver.solve(matrix, newton_update, rhs, preconditioner_ssor_sym);
+	}
+	else if (tangent_type == "BlockSparse")
+	{
+		solver.solve(matrix, newton_update, rhs, preconditioner_ssor_bsr);
+	}
+	else if (preconditioner_type == "Multigrid")
+	{
+		solver.solve(matrix, newton_update, rhs, multigrid.get_preconditioner());
+	}
+	else
+	{
+		solver.solve(matrix, newton_update, rhs, preconditioner_ssor);
+	}
+}
 
-	/*Clear and write hanging node and Dirichlet constraints into
-	 the affine_constraints constraints*/
-    constraints.clear();
-	DoFTools::make_hanging_node_constraints (dof_handler_ref,constraints);
-    const bool apply_dirichlet_bc = (it_nr == 0);
-	const FEValuesExtractors::Vector displacement(0);
-	const int boundary_id = id_Dirichlet_boundary;
 
-	/*if conditional to check which function should be used for the Dirichlet constraints*/
-	if (apply_dirichlet_bc == true)
+template <int dim>
+template <typename SolverType>
+void Solid<dim>::solve_tangent(SolverType &solver,
+								Vector<double> &newton_update,
+								const Vector<double> &rhs)
+{
+	if (tangent_type == "MatrixFree")
 	{
-		VectorTools::interpolate_boundary_values(dof_handler_ref,
-												boundary_id,
-												ZeroFunction<dim>(dim),
-												constraints,
-												fe.component_mask(displacement));
+		solve_preconditioned(solver, *mf_operator, newton_update, rhs);
+	}
+	else if (tangent_type == "SparseSymmetric")
+	{
+		solve_preconditioned(solver, tangent_matrix_sym, newton_update, rhs);
+	}
+	else if (tangent_type == "BlockSparse")
+	{
+		solve_preconditioned(solver, tangent_matrix_bsr, newton_update, rhs);
 	}
 	else
 	{
-		VectorTools::interpolate_boundary_values(dof_handler_ref,
-												boundary_id,
-												ZeroFunction<dim>(dim),
-												constraints,
-												fe.component_mask(displacement));	
+		solve_preconditioned(solver, tangent_matrix, newton_update, rhs);
 	}
-    constraints.close();
 }
 
+
 template <int dim>
-void Solid<dim>::assemble_system()
+void Solid<dim>::assemble_multigrid_matrices()
 {
-	
-	
-		std::cout << " Assemble System " << std::flush;
-
-	
-	NeoHookeanMaterial<dim> material(this->mu, this->lambda);
-	
-	//FEValues and FaceValues to compute quantities on quadrature points for our finite
-	//element space including mapping from the real cell
-	FEValues<dim> fe_values_ref (fe,//The used FiniteElement
-								qf_cell,//The quadrature rule for the cell
-								update_values| //UpdateFlag for shape function values
-								update_gradients| //shape function gradients
-								update_JxW_values); //transformed quadrature weights multiplied with Jacobian of transformation 
-	FEFaceValues<dim> fe_face_values_ref (fe,
-										qf_face, //The quadrature for face quadrature points
-										update_values|
-										update_normal_vectors| //compute normal vector for face
-										update_JxW_values);
-
-	//Quantities to store the local rhs and matrix contribution
-	FullMatrix<double> cell_matrix(dofs_per_cell,dofs_per_cell);
-	Vector<double> cell_rhs (dofs_per_cell);
-	//Vector with the indicies (global) of the local dofs	
-	std::vector<types::global_dof_index> local_dof_indices (dofs_per_cell);
-	//Compute the current, total solution, i.e. starting value of
-	//current load step and current solution_delta
-	Vector<double> current_solution = get_total_solution(this->solution_delta);
-	//Iterators to loop over all active cells
-	typename DoFHandler<dim>::active_cell_iterator cell = dof_handler_ref.begin_active(),
-												endc = dof_handler_ref.end();
-												
-	for(;cell!=endc;++cell)
+	get_total_solution(this->solution_delta, solution_total_trial);
+	const Vector<double> &current_solution = solution_total_trial;
+
+	//The level cells are not part of reference_geometry, their gradients are
+	//computed here in the same layout
+	FEValues<dim> &fe_values_ref = scratch_level->fe_values_ref;
+	PerTaskData_ASM &data = per_task_data_serial;
+	ScratchData_ASM &scratch = *scratch_serial;
+	std::vector<Tensor<1,dim> > &shape_gradients_ref = scratch_level->shape_gradients_ref;
+	std::vector<double> &JxW_values = scratch_level->JxW_values;
+	Vector<double> &local_solution = scratch_level->local_solution;
+	const std::vector<unsigned int> &shape_component = reference_geometry.shape_component;
+
+	multigrid.reset_matrices();
+	for (unsigned int level = 0; level < triangulation.n_levels(); ++level)
 	{
-		//Reset the local rhs and matrix for every cell
-		cell_matrix=0.0;
-		cell_rhs=0.0;
-		//Reinit the FEValues instance for the current cell, i.e.
-		//compute the values for the current cell
-		fe_values_ref.reinit(cell);
-		//Vector to store the gradients of the solution at 
-		//n_q_points quadrature points
-		std::vector<Tensor<2,dim> > solution_grads_u(n_q_points);
-		//Fill the previous vector using get_function_gradients
-		fe_values_ref[u_fe].get_function_gradients(current_solution,solution_grads_u);
-		//Write the global indicies of the local dofs of the current cell
-		cell->get_dof_indices(local_dof_indices);
-
-		//Loop over all quadrature points of the cell
-		for(unsigned int k=0; k<n_q_points;++k)
+		typename DoFHandler<dim>::cell_iterator cell = dof_handler_ref.begin(level),
+												endc = dof_handler_ref.end(level);
+		for (; cell != endc; ++cell)
 		{
-			//BEGIN - INSERT YOUR CODE HERE
-			//Compute here the following
-			//
-			//- deformation gradient using the information in "solution_grads_u[k]" and Physics::Elasticity::StandardTensors<dim>::I
-			//- use the deformation gradient to compute
-			//- - Kirchhoffstress
-			//- - Tangent
-			//- Compute the inverse of the Deformation gradient
-			Tensor<2,dim> DeformationGradient =  (Tensor<2, dim>(Physics::Elasticity::StandardTensors<dim>::I) + solution_grads_u[k]);
-			SymmetricTensor<2,dim> Kirchhoffstress = material.get_KirchhoffStress(DeformationGradient);
-			SymmetricTensor<4,dim> Tangent = material.get_Tangent_spt(DeformationGradient);
-			Tensor<2,dim> F_inv = invert(DeformationGradient);
-			//END - INSERT YOUR CODE HERE
-			
-			//The quadrature weight for the current quadrature point
-			const double JxW = fe_values_ref.JxW(k);
-			//Loop over all dof's of the cell
-			for(unsigned int i=0; i<dofs_per_cell; ++i)
+			data.reset();
+			fe_values_ref.reinit(cell);
+			for (unsigned int k = 0; k < n_q_points; ++k)
 			{
-				//Assemble system_rhs contribution
-				//BEGIN - INSERT YOUR CODE HERE
-				
-				//Compute here the following
-				//
-				//- the symmetric (SymmetricTensor<2,dim>) gradient with respect to the spatial configuration
-				//  for the test function as discussed in the exercise (i) -> use fe_values_ref[u_fe] and F_inv
-				//- write into cell_rhs(i)-= the contribution for the current test function at the current quadrature point
-				//  !! "-=" due to Newton-Raphson algorithm K\du = -r
-				Tensor<2,dim> shape_gradient_wrt_ref_config_i = fe_values_ref[u_fe].gradient(i,k);
-				Tensor<2,dim> shape_gradient_wrt_spt_config_i = shape_gradient_wrt_ref_config_i * F_inv;
-				SymmetricTensor<2,dim> sym_shape_gradient_wrt_spt_config_i = 
-					symmetrize(shape_gradient_wrt_spt_config_i);
-				
-				cell_rhs(i)-= (sym_shape_gradient_wrt_spt_config_i * Kirchhoffstress) * JxW;
-				//END - INSERT YOUR CODE HERE
-				
-				for(unsigned int j=0; j<dofs_per_cell; ++j)
+				JxW_values[k] = fe_values_ref.JxW(k);
+				for (unsigned int i = 0; i < dofs_per_cell; ++i)
 				{
-					//Assemble tangent contribution
-					//BEGIN - INSERT YOUR CODE HERE
-				
-					//Compute here the following
-					//
-					//- the symmetric (SymmetricTensor<2,dim>) gradient with respect to the spatial configuration
-					//  for the ansatz function as discussed in the exercise (j) -> use fe_values_ref[u_fe] and F_inv
-					//- write into cell_matrix(i,j) the material and geometrical contributions for the tangent
-					Tensor<2,dim> shape_gradient_wrt_ref_config_j = fe_values_ref[u_fe].gradient(j,k);
-					Tensor<2,dim> shape_gradient_wrt_spt_config_j =shape_gradient_wrt_ref_config_j * F_inv;
-					SymmetricTensor<2,dim> sym_shape_gradient_wrt_spt_config_j = 
-						symmetrize(shape_gradient_wrt_spt_config_j);	
-
-					cell_matrix(i,j) += (( symmetrize (transpose(shape_gradient_wrt_spt_config_i) * 
-											shape_gradient_wrt_spt_config_j) * Kirchhoffstress ) //geometrical contribution
-										+ (sym_shape_gradient_wrt_spt_config_i * Tangent // The material contribution:
-											* sym_shape_gradient_wrt_spt_config_j) )
-										* JxW;		
-					//END - INSERT YOUR CODE HERE					
+					shape_gradients_ref[k * dofs_per_cell + i]
+						= fe_values_ref.shape_grad_component(i, k, shape_component[i]);
 				}
 			}
+			//Restriction of the solution of the active descendants to this cell
+			cell->get_interpolated_dof_values(current_solution, local_solution);
+			std::copy(local_solution.begin(), local_solution.end(), scratch.local_solution.begin());
+			cell->get_mg_dof_indices(data.local_dof_indices);
+
+			assemble_cell_quadrature(shape_gradients_ref.data(), JxW_values.data(), scratch, data);
+			multigrid.add_cell_matrix(level, data.cell_matrix, data.local_dof_indices);
 		}
+	}
+	multigrid.rebuild();
+}
 
+template <int dim>
+void Solid<dim>::update_tangent(const bool assembled_with_residual)
+{
+	if (assembled_with_residual)
+	{
+		/*The tangent of this iterate is already in place*/
+	}
+	else if (tangent_type == "MatrixFree")
+	{
+		/*Cache stress and tangent of the current Newton iterate at the quadrature points*/
+		get_total_solution(solution_delta, solution_total);
+		mf_operator->set_linearization_point(solution_total);
+	}
+	else
+	{
+		reset_tangent();
+		assemble_system(tangent_only);
+	}
+	tangent_changed = true;
+	tangent_discarded = false;
+	++n_tangent_assemblies;
+}
 
+template <int dim>
+std::pair<unsigned int, double>
+Solid<dim>::solve_quasi_newton(Vector<double> &newton_update, const double relative_tolerance)
+{
+	std::cout << " BFGS(" << n_bfgs_pairs << ") " << std::flush;
+	/*Two-loop recursion applied to the negative gradient system_rhs, the pairs are
+	 stored newest first*/
+	Vector<double> &q = quasi_newton_rhs;
+	q = system_rhs;
+	for (unsigned int i = 0; i < n_bfgs_pairs; ++i)
+	{
+		BFGSPair &pair = bfgs_pairs[i];
+		pair.alpha = pair.rho * (pair.s * q);
+		q.add(-pair.alpha, pair.y);
+	}
+	/*The initial inverse is the last assembled tangent*/
+	const std::pair<unsigned int, double>
+	lin_solver_output = solve_linear_system(newton_update, relative_tolerance, q);
+	for (unsigned int i = n_bfgs_pairs; i-- > 0;)
+	{
+		const BFGSPair &pair = bfgs_pairs[i];
+		const double beta = pair.rho * (pair.y * newton_update);
+		newton_update.add(pair.alpha - beta, pair.s);
+	}
+	return lin_solver_output;
+}
 
-		//Check for Neumann boundary condition
-		for(unsigned int face=0; face < GeometryInfo<dim>::faces_per_cell; ++face)
-		{
-			if(cell->face(face)->at_boundary() && cell->face(face)->boundary_id() == id_Neumann_boundary )
-			{
-				fe_face_values_ref.reinit(cell, face);
-				
-				for(unsigned int f_q_point = 0; f_q_point < n_q_points_f; ++f_q_point)
-				{
-					double step_fraction = double(current_load_step)/double(load_steps);
-					double current_load = load_magnitude * step_fraction;
-					//Compute the following
-					//
-					//- The normal vector of the current face at the current quadrature point (fe_face_values_ref)
-					//- The normal vector scaled with "current_load"
-					const Tensor<1,dim> NormalVector = fe_face_values_ref.normal_vector(f_q_point);
-					const Tensor<1,dim> Traction = current_load  * NormalVector;					
+template <int dim>
+double Solid<dim>::get_forcing_term(const double error_residual_previous,
+									const double forcing_term_previous) const
+{
+	/*First Newton iteration: no history yet*/
+	if (error_residual_previous == 0.0)
+	{
+		return std::min(0.5, forcing_term_max);
+	}
+	/*Choice 2 of Eisenstat and Walker with gamma = 0.9, alpha = 2*/
+	const double gamma = 0.9;
+	const double alpha = 2.0;
+	double forcing_term = gamma * std::pow(error_residual.u / error_residual_previous, alpha);
+	/*Safeguard against a too fast decrease of the forcing terms*/
+	const double forcing_term_safeguard = gamma * std::pow(forcing_term_previous, alpha);
+	if (forcing_term_safeguard > 0.1)
+	{
+		forcing_term = std::max(forcing_term, forcing_term_safeguard);
+	}
+	/*Do not solve more accurately than needed to reach the nonlinear tolerance*/
+	forcing_term = std::max(forcing_term, 0.5 * error_tolerance_residual / error_residual_norm.u);
+	return std::max(relative_tolerance_linear_solver, std::min(forcing_term, forcing_term_max));
+}
 
-					for(unsigned int i = 0; i< dofs_per_cell; ++i)
-					{
-						//Compute
-						//
-						//- the test function at the face quadrature point for the i-th test function
-						//- write into cell_rhs(i)+= the contribution due to the Neumann boundary condition (-=(-))->+=
-						//!! Don't forget the JxW value of that face!!
-						const Tensor<1,dim> shape_function = fe_face_values_ref[u_fe].value(i,f_q_point);
-						cell_rhs(i)+= (shape_function * Traction) * fe_face_values_ref.JxW(f_q_point);
-					}
-				}
-			}
+template <int dim>
+void Solid<dim>::run_krylov_solver(SolverControl &solver_control,
+								Vector<double> &solution,
+								const Vector<double> &rhs,
+								const bool record_statistics)
+{
+	GrowingVectorMemory<Vector<double> > GVM;
+	if (solver_type == "JFNK")
+	{
+		/*The Jacobian of the current iterate is applied through residual evaluations,
+		 the (possibly older) tangent only enters the preconditioner. The finite
+		 difference operator is not exactly symmetric, i.e. GMRES instead of CG. The
+		 residual at the linearization point comes from the same evaluation as the
+		 perturbed ones, such that their difference holds no assembly round-off*/
+		residual_jacobian_free = 0.0;
+		assemble_residual(solution_delta, residual_jacobian_free);
+		get_total_solution(solution_delta, solution_total);
+		const JacobianFreeOperator jacobian([this](const Vector<double> &solution_delta_trial,
+													Vector<double> &residual)
+											{
+												residual = 0.0;
+												this->assemble_residual(solution_delta_trial, residual);
+											},
+											solution_delta,
+											residual_jacobian_free,
+											solution_total.l2_norm(),
+											constraints);
+		SolverGMRES<Vector<double> > solver_GMRES(solver_control, GVM,
+				typename SolverGMRES<Vector<double> >::AdditionalData(50, true));
+		solve_preconditioned(solver_GMRES, jacobian, solution, rhs);
+		std::cout << "RES_EVAL " << jacobian.n_residual_evaluations() + 1 << " " << std::flush;
+	}
+	else if (solver_type == "SingleReductionCG")
+	{
+		SolverSingleReductionCG solver_single_reduction_CG(solver_control);
+		solve_tangent(solver_single_reduction_CG, solution, rhs);
+	}
+	else if (solver_type == "DeflatedCG")
+	{
+		/*The Galerkin solution in the space of the previous solutions is the initial
+		 guess and CG only iterates on the remaining modes*/
+		SolverDeflatedCG solver_deflated_CG(solver_control, recycling_subspace.get_basis(),
+											deflation_workspace);
+		solve_tangent(solver_deflated_CG, solution, rhs);
+		if (!record_statistics)
+		{
+			return;
 		}
-		//copy local to global
-		constraints.distribute_local_to_global(cell_matrix,cell_rhs,
-								local_dof_indices,
-								tangent_matrix,system_rhs,false);
-		
-
+		n_lin_it_deflated += solver_control.last_step();
+		n_deflation_products += recycling_subspace.get_basis().size();
+		std::cout << "DIM " << recycling_subspace.get_basis().size() << " " << std::flush;
+		if (report_recycling_savings)
+		{
+			SolverControl solver_control_reference(solver_control.max_steps(), solver_control.tolerance());
+			SolverCG<Vector<double> > solver_CG_reference(solver_control_reference, GVM);
+			Vector<double> solution_reference(solution.size());
+			solve_tangent(solver_CG_reference, solution_reference, rhs);
+			n_lin_it_reference += solver_control_reference.last_step();
+			std::cout << "REF_IT " << solver_control_reference.last_step() << " " << std::flush;
+		}
+		/*The constrained entries of the solution are zero, as those of the rhs*/
+		recycling_subspace.add(solution);
+	}
+	else if (solver_type == "Direct")
+	{
+#ifdef DEAL_II_WITH_UMFPACK
+		/*The factorization of an older tangent preconditions CG with the current one*/
+		SolverCG<Vector<double> > solver_CG(solver_control, GVM);
+		solver_CG.solve(tangent_matrix, solution, rhs, direct_solver);
+#endif
+	}
+	else
+	{
+		SolverCG<Vector<double> > solver_CG(solver_control, GVM);
+		solve_tangent(solver_CG, solution, rhs);
 	}
 }
 
+
 template <int dim>
 std::pair<unsigned int, double>
-Solid<dim>::solve_linear_system(Vector<double> &newton_update)
+Solid<dim>::solve_linear_system(Vector<double> &newton_update, const double relative_tolerance,
+								const Vector<double> &rhs)
 {
 
 	unsigned int lin_it = 0;
 	double lin_res = 0.0;
-	std::string solver_type = "CG";
 	/*reset the vector newton update*/
 	newton_update=0;
-	
+	const int solver_its = dof_handler_ref.n_dofs()
+							* multiplier_max_iterations_linear_solver;
 
 	std::cout << " SLV " << std::flush;
-	if (solver_type == "CG")
+	if (solver_type == "CG" || solver_type == "SingleReductionCG" || solver_type == "DeflatedCG"
+		|| solver_type == "JFNK")
 	{
-		const int solver_its = tangent_matrix.m()
-								* multiplier_max_iterations_linear_solver;
-		const double tol_sol = 1e-9
-								* system_rhs.l2_norm();
+		const double tol_sol = relative_tolerance
+								* rhs.l2_norm();
 
 		SolverControl solver_control(solver_its, tol_sol);
 
-		GrowingVectorMemory<Vector<double> > GVM;
-		SolverCG<Vector<double> > solver_CG(solver_control, GVM);
-		PreconditionSSOR<> preconditioner;
-		preconditioner.initialize(tangent_matrix, 1.2);
-		solver_CG.solve(tangent_matrix,
-						newton_update,
-						system_rhs,
-						preconditioner);
+		/*Set up multigrid or Chebyshev only if the policy asks for it, otherwise the one
+		 of the previous solve is applied. SSOR only needs its setup once per numbering,
+		 Jacobi a new diagonal for every linearization point*/
+		Timer timer;
+		if (uses_preconditioner_policy())
+		{
+			if (preconditioner_policy.decide())
+			{
+				setup_preconditioner();
+				std::cout << "PC rebuilt (" << preconditioner_policy.get_reason() << ", "
+						<< std::fixed << std::setprecision(3) << timer.wall_time() << "s) " << std::flush;
+			}
+			else
+			{
+				std::cout << "PC reused " << std::flush;
+			}
+		}
+		else if (!preconditioner_set_up || (tangent_type == "MatrixFree" && tangent_changed))
+		{
+			setup_preconditioner();
+			preconditioner_set_up = true;
+		}
+		tangent_changed = false;
+
+		run_krylov_solver(solver_control, newton_update, rhs, true);
 		lin_it = solver_control.last_step();
 		lin_res = solver_control.last_value();
+		preconditioner_policy.record_solve(lin_it, solver_control.initial_value(), lin_res);
+	}
+	else if (solver_type == "Direct")
+	{
+		AssertThrow (tangent_type == "Sparse",
+					ExcMessage("The direct solver needs the tangent_type Sparse"));
+#ifdef DEAL_II_WITH_UMFPACK
+		/*Only the numeric factorization is repeated, the sparsity pattern (and with it
+		 the symbolic analysis) is the same for all Newton iterations. Like a
+		 preconditioner it is only repeated for a new tangent if the policy asks for it*/
+		if (tangent_changed)
+		{
+			if (preconditioner_policy.decide())
+			{
+				direct_solver.factorize(tangent_matrix);
+				factorization_current = true;
+				std::cout << "LU rebuilt (" << preconditioner_policy.get_reason() << ") fill "
+						<< std::fixed << std::setprecision(2) << direct_solver.get_fill_factor()
+						<< std::setprecision(3);
+				if (!direct_solver.symbolic_analysis_reused())
+				{
+					std::cout << " sym " << direct_solver.get_symbolic_time() << "s";
+				}
+				std::cout << " num " << direct_solver.get_numeric_time() << "s " << std::flush;
+			}
+			else
+			{
+				factorization_current = false;
+				std::cout << "LU reused " << std::flush;
+			}
+			tangent_changed = false;
+		}
+
+		if (factorization_current)
+		{
+			direct_solver.solve(newton_update, rhs);
+			/*No iterations, the residual of the linear system is reported instead*/
+			lin_res = tangent_matrix.residual(linear_residual, newton_update, rhs);
+			std::cout << "solve " << std::fixed << std::setprecision(3)
+					<< direct_solver.get_solve_time() << "s " << std::flush;
+		}
+		else
+		{
+			/*The factorization of an older tangent preconditions CG with the current one;
+			 the iterations decide about the next factorization*/
+			SolverControl solver_control(solver_its, relative_tolerance * rhs.l2_norm());
+			run_krylov_solver(solver_control, newton_update, rhs, true);
+			lin_it = solver_control.last_step();
+			lin_res = solver_control.last_value();
+			preconditioner_policy.record_solve(lin_it, solver_control.initial_value(), lin_res);
+		}
+#else
+		AssertThrow (false, ExcNeedsUMFPACK());
+#endif
 	}
 	else
 	{
 		/*throug an error message that the chosen solver type is not implented*/
 		Assert (false, ExcMessage("Linear solver type not implemented"));
 	}
+	/*Iterations a solve to relative_tolerance_linear_solver would have needed: the same
+	 system is solved a second time with the same method and preconditioner. Exact
+	 direct solves do not depend on the forcing term*/
+	if (report_forcing_savings && lin_it > 0 && relative_tolerance > relative_tolerance_linear_solver)
+	{
+		SolverControl solver_control_reference(solver_its, relative_tolerance_linear_solver * rhs.l2_norm());
+		Vector<double> newton_update_reference(newton_update.size());
+		run_krylov_solver(solver_control_reference, newton_update_reference, rhs, false);
+		if (solver_control_reference.last_step() > lin_it)
+		{
+			n_lin_it_saved += solver_control_reference.last_step() - lin_it;
+		}
+		std::cout << "FULL_IT " << solver_control_reference.last_step() << " " << std::flush;
+	}
 	/*Write the constraint values into the solution vector (newton-increment) to ensure
 	 that these values are used in the sequent*/
 	constraints.distribute(newton_update);
@@ -709,7 +3762,7 @@ Solid<dim>::solve_linear_system(Vector<double> &newton_update)
 }
 
 
-int main ()
+int main (int argc, char *argv[])
 {
   using namespace dealii;
 
@@ -719,12 +3772,47 @@ int main ()
     {
       deallog.depth_console(1);
 
-	  unsigned int loadsteps=10;
-	  unsigned int polydegree=1;
-	  double load_magnitude=(-7e+3);
-	  double mu=70000;
-	  double lambda=105000;
+	  /*Runtime options of Solid, read from the input file given as the first argument or
+	   from parameters.prm in the working directory if it exists; entries missing in the
+	   file keep the defaults of Solid::declare_parameters*/
+	  ParameterHandler prm;
+	  Solid<dim>::declare_parameters(prm);
+	  const std::string parameter_file = (argc > 1 ? argv[1] : "parameters.prm");
+	  std::ifstream parameter_input(parameter_file);
+	  if (parameter_input)
+	  {
+		  prm.parse_input(parameter_input, parameter_file);
+		  std::cout << "Parameters read from " << parameter_file << std::endl;
+	  }
+	  else
+	  {
+		  AssertThrow (argc <= 1, ExcMessage("Parameter file " + parameter_file + " not found"));
+	  }
+
+	  prm.enter_subsection("Problem");
+	  const unsigned int loadsteps = prm.get_integer("Load steps");
+	  const unsigned int polydegree = prm.get_integer("Polynomial degree");
+	  const double load_magnitude = prm.get_double("Load magnitude");
+	  const double mu = prm.get_double("Shear modulus");
+	  const double lambda = prm.get_double("Lambda");
+	  prm.leave_subsection();
+	  /*Time the runtime-degree, the fixed-size and the Voigt cell kernels for the degrees
+	   1 to 4 instead of running the computation*/
+	  prm.enter_subsection("Assembly");
+	  const bool benchmark_cell_kernels = prm.get_bool("Benchmark cell kernels");
+	  prm.leave_subsection();
+	  if (benchmark_cell_kernels)
+	  {
+		  for (unsigned int degree = 1; degree <= 4; ++degree)
+		  {
+			  Solid<dim> solid_xd(loadsteps, degree, load_magnitude, mu, lambda);
+			  solid_xd.parse_parameters(prm);
+			  solid_xd.benchmark_cell_kernels();
+		  }
+		  return 0;
+	  }
       Solid<dim> solid_xd(loadsteps, polydegree, load_magnitude, mu, lambda);
+      solid_xd.parse_parameters(prm);
       solid_xd.run();
     }
   catch (std::exception &exc)
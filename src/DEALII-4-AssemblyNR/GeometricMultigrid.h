@@ -0,0 +1,200 @@
+#ifndef GEOMETRICMULTIGRID_H
+#define GEOMETRICMULTIGRID_H
+
+#include <deal.II/base/index_set.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/lac/affine_constraints.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/full_matrix.h>
+#include <deal.II/lac/precondition.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/sparsity_pattern.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/multigrid/mg_coarse.h>
+#include <deal.II/multigrid/mg_constrained_dofs.h>
+#include <deal.II/multigrid/mg_matrix.h>
+#include <deal.II/multigrid/mg_smoother.h>
+#include <deal.II/multigrid/mg_tools.h>
+#include <deal.II/multigrid/mg_transfer.h>
+#include <deal.II/multigrid/multigrid.h>
+
+#include <memory>
+#include <set>
+#include <vector>
+
+using namespace dealii;
+
+/*! \brief Geometric multigrid V-cycle on the level hierarchy of a locally refined mesh
+ *
+ * The level matrices are assembled by the user cell by cell on every level (including
+ * the non-active cells) and handed to add_cell_matrix(), which applies the zero
+ * Dirichlet constraints of the level and fills the interface matrices at the refinement
+ * edges needed for local refinement. After all level matrices are assembled, rebuild()
+ * factorizes the coarse level. The smoother is SSOR, i.e. the preconditioner is
+ * symmetric and can be used within CG.
+ *
+ * The DoFHandler must have its level dofs distributed (distribute_mg_dofs) and the
+ * triangulation has to be created with the mesh smoothing
+ * Triangulation<dim>::limit_level_difference_at_vertices.
+ */
+template <int dim>
+class GeometricMultigrid
+{
+	public:
+		typedef PreconditionMG<dim, Vector<double>, MGTransferPrebuilt<Vector<double> > > PreconditionerType;
+
+		/*! Set up the level sparsity patterns, the transfer between the levels and the
+		 * multigrid objects. The Dirichlet boundaries are constrained in all components
+		 */
+		void initialize(const DoFHandler<dim> &dof_handler,
+						const std::set<types::boundary_id> &dirichlet_boundary_ids);
+		/*! Set all level matrices to zero before they are assembled again
+		 */
+		void reset_matrices();
+		/*! Add the matrix of a cell of the given level with the level dof indices
+		 */
+		void add_cell_matrix(const unsigned int level,
+							const FullMatrix<double> &cell_matrix,
+							const std::vector<types::global_dof_index> &local_dof_indices);
+		/*! Factorize the coarse level matrix, to be called once the level matrices are assembled
+		 */
+		void rebuild();
+		const PreconditionerType &get_preconditioner() const
+		{
+			return *preconditioner;
+		}
+		unsigned int n_levels() const
+		{
+			return matrices.max_level() + 1;
+		}
+		std::size_t memory_consumption() const
+		{
+			std::size_t memory = mg_transfer->memory_consumption();
+			for (unsigned int level = 0; level < n_levels(); ++level)
+				memory += (matrices[level].memory_consumption()
+						+ interface_matrices[level].memory_consumption()
+						+ sparsity_patterns[level].memory_consumption());
+			return memory;
+		}
+
+	private:
+		MGConstrainedDoFs                               mg_constrained_dofs;
+		MGLevelObject<SparsityPattern>                  sparsity_patterns;
+		MGLevelObject<SparseMatrix<double> >            matrices;
+		/*! Couplings between dofs at the refinement edges and the interior of a level */
+		MGLevelObject<SparseMatrix<double> >            interface_matrices;
+		/*! Zero Dirichlet and refinement edge constraints of every level */
+		std::vector<AffineConstraints<double> >         level_constraints;
+
+		std::unique_ptr<MGTransferPrebuilt<Vector<double> > > mg_transfer;
+		FullMatrix<double>                              coarse_matrix;
+		MGCoarseGridHouseholder<double, Vector<double> > coarse_grid_solver;
+		mg::SmootherRelaxation<PreconditionSSOR<SparseMatrix<double> >, Vector<double> > smoother;
+		mg::Matrix<Vector<double> >                     mg_matrix;
+		mg::Matrix<Vector<double> >                     mg_interface_up;
+		mg::Matrix<Vector<double> >                     mg_interface_down;
+		std::unique_ptr<Multigrid<Vector<double> > >    multigrid;
+		std::unique_ptr<PreconditionerType>             preconditioner;
+};
+
+
+
+
+//Definition of the member functions
+//-----------------------------------------------------------
+//-----------------------------------------------------------
+template <int dim>
+void GeometricMultigrid<dim>::initialize(const DoFHandler<dim> &dof_handler,
+										const std::set<types::boundary_id> &dirichlet_boundary_ids)
+{
+	//Release the objects referring to the level matrices first
+	preconditioner.reset();
+	multigrid.reset();
+
+	mg_constrained_dofs.clear();
+	mg_constrained_dofs.initialize(dof_handler);
+	mg_constrained_dofs.make_zero_boundary_constraints(dof_handler, dirichlet_boundary_ids);
+
+	const unsigned int n_levels = dof_handler.get_triangulation().n_levels();
+	sparsity_patterns.resize(0, n_levels - 1);
+	matrices.resize(0, n_levels - 1);
+	interface_matrices.resize(0, n_levels - 1);
+	level_constraints.assign(n_levels, AffineConstraints<double>());
+	for (unsigned int level = 0; level < n_levels; ++level)
+	{
+		DynamicSparsityPattern dsp(dof_handler.n_dofs(level), dof_handler.n_dofs(level));
+		MGTools::make_sparsity_pattern(dof_handler, dsp, level);
+		sparsity_patterns[level].copy_from(dsp);
+		matrices[level].reinit(sparsity_patterns[level]);
+		interface_matrices[level].reinit(sparsity_patterns[level]);
+
+		level_constraints[level].add_lines(mg_constrained_dofs.get_refinement_edge_indices(level));
+		level_constraints[level].add_lines(mg_constrained_dofs.get_boundary_indices(level));
+		level_constraints[level].close();
+	}
+
+	mg_transfer.reset(new MGTransferPrebuilt<Vector<double> >(mg_constrained_dofs));
+	mg_transfer->build(dof_handler);
+
+	//The smoothers and level operators only keep pointers to the level matrices,
+	//i.e. they always work with their current entries
+	smoother.initialize(matrices, typename PreconditionSSOR<SparseMatrix<double> >::AdditionalData(1.0));
+	smoother.set_steps(2);
+	smoother.set_symmetric(true);
+	mg_matrix.initialize(matrices);
+	mg_interface_up.initialize(interface_matrices);
+	mg_interface_down.initialize(interface_matrices);
+
+	multigrid.reset(new Multigrid<Vector<double> >(mg_matrix,
+													coarse_grid_solver,
+													*mg_transfer,
+													smoother,
+													smoother));
+	multigrid->set_edge_matrices(mg_interface_down, mg_interface_up);
+	preconditioner.reset(new PreconditionerType(dof_handler, *multigrid, *mg_transfer));
+}
+
+
+
+template <int dim>
+void GeometricMultigrid<dim>::reset_matrices()
+{
+	for (unsigned int level = 0; level < n_levels(); ++level)
+	{
+		matrices[level] = 0.;
+		interface_matrices[level] = 0.;
+	}
+}
+
+
+
+template <int dim>
+void GeometricMultigrid<dim>::add_cell_matrix(const unsigned int level,
+											const FullMatrix<double> &cell_matrix,
+											const std::vector<types::global_dof_index> &local_dof_indices)
+{
+	level_constraints[level].distribute_local_to_global(cell_matrix,
+														local_dof_indices,
+														matrices[level]);
+	for (unsigned int i = 0; i < local_dof_indices.size(); ++i)
+		for (unsigned int j = 0; j < local_dof_indices.size(); ++j)
+			if (mg_constrained_dofs.is_interface_matrix_entry(level,
+															local_dof_indices[i],
+															local_dof_indices[j]))
+				interface_matrices[level].add(local_dof_indices[i],
+											local_dof_indices[j],
+											cell_matrix(i, j));
+}
+
+
+
+template <int dim>
+void GeometricMultigrid<dim>::rebuild()
+{
+	//The coarse mesh is small, it is solved directly
+	coarse_matrix.copy_from(matrices[0]);
+	coarse_grid_solver.initialize(coarse_matrix);
+}
+//----------------------------------------------------------------------------
+
+#endif
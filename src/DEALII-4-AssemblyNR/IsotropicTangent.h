@@ -0,0 +1,85 @@
+#ifndef ISOTROPICTANGENT_H
+#define ISOTROPICTANGENT_H
+
+#include <deal.II/base/symmetric_tensor.h>
+#include <deal.II/physics/elasticity/standard_tensors.h>
+
+using namespace dealii;
+
+/*! \brief Fourth order tangent of the isotropic form
+ * \f$ \mathbb{c} = a \, \mathbf{I} \otimes \mathbf{I} + b \, \mathbb{S} \f$
+ *
+ * Only the two coefficients are stored. The double contractions needed in the
+ * assembly reduce to
+ * \f$ \boldsymbol{\varepsilon}_1 : \mathbb{c} : \boldsymbol{\varepsilon}_2
+ * = a \, \text{tr}\left( \boldsymbol{\varepsilon}_1 \right) \text{tr}\left( \boldsymbol{\varepsilon}_2 \right)
+ * + b \, \boldsymbol{\varepsilon}_1 : \boldsymbol{\varepsilon}_2 \f$
+ * instead of forming and contracting a SymmetricTensor<4,dim>. Materials
+ * without this structure, e.g. anisotropic ones, keep returning a
+ * SymmetricTensor<4,dim>.
+ *
+ * The number type is a template parameter such that the class can also be
+ * used with VectorizedArray in the matrix-free operator.
+ */
+template <int dim, typename Number = double>
+class IsotropicTangent
+{
+	public:
+		IsotropicTangent(){}
+
+		/*! @param coefficient_IxI The coefficient \f$ a \f$ of \f$ \mathbf{I} \otimes \mathbf{I} \f$
+		 * @param coefficient_S The coefficient \f$ b \f$ of \f$ \mathbb{S} \f$
+		 */
+		IsotropicTangent(const Number &coefficient_IxI, const Number &coefficient_S)
+		:
+		coefficient_IxI(coefficient_IxI),
+		coefficient_S(coefficient_S)
+		{}
+
+		/*! @return \f$ \boldsymbol{\varepsilon}_1 : \mathbb{c} : \boldsymbol{\varepsilon}_2 \f$
+		 */
+		Number contract(const SymmetricTensor<2, dim, Number> &eps_1,
+						const SymmetricTensor<2, dim, Number> &eps_2) const
+		{
+			return (coefficient_IxI * trace(eps_1) * trace(eps_2)
+					+ coefficient_S * (eps_1 * eps_2));
+		}
+
+		/*! @return \f$ \mathbb{c} : \boldsymbol{\varepsilon} \f$
+		 */
+		SymmetricTensor<2, dim, Number> operator*(const SymmetricTensor<2, dim, Number> &eps) const
+		{
+			SymmetricTensor<2, dim, Number> result = coefficient_S * eps;
+			const Number trace_eps = trace(eps);
+			for (unsigned int d = 0; d < dim; ++d)
+				result[d][d] += coefficient_IxI * trace_eps;
+			return result;
+		}
+
+		/*! The tangent as a full SymmetricTensor<4,dim>, for the generic code path.
+		 * Written entry by entry, such that no tensor of double is combined with Number
+		 */
+		SymmetricTensor<4, dim, Number> get_SymmetricTensor() const
+		{
+			SymmetricTensor<4, dim, Number> result;
+			for (unsigned int i = 0; i < dim; ++i)
+				for (unsigned int j = i; j < dim; ++j)
+					for (unsigned int k = 0; k < dim; ++k)
+						for (unsigned int l = k; l < dim; ++l)
+						{
+							//S_ijkl = (delta_ik delta_jl + delta_il delta_jk)/2
+							result[i][j][k][l] = coefficient_S * (0.5 * ((i == k && j == l) + (i == l && j == k)));
+							if (i == j && k == l)
+								result[i][j][k][l] += coefficient_IxI;
+						}
+			return result;
+		}
+
+		//member variables
+		/*! The coefficient \f$ a \f$ */
+		Number coefficient_IxI;
+		/*! The coefficient \f$ b \f$ */
+		Number coefficient_S;
+};
+
+#endif
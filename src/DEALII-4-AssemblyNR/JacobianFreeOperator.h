@@ -0,0 +1,95 @@
+#ifndef JACOBIANFREEOPERATOR_H
+#define JACOBIANFREEOPERATOR_H
+
+#include <deal.II/base/subscriptor.h>
+#include <deal.II/lac/affine_constraints.h>
+#include <deal.II/lac/vector.h>
+
+#include <cmath>
+#include <functional>
+#include <limits>
+
+using namespace dealii;
+
+/*! \brief Action of the Jacobian by finite differences of the residual (Jacobian-free Newton-Krylov)
+ *
+ * The residual is given as a function that computes, for an arbitrary trial increment
+ * \f$ \Delta \mathbf{u} \f$, the negative residual \f$ \mathbf{r}(\Delta \mathbf{u}) \f$
+ * in the same form as system_rhs. The Jacobian is applied as the directional derivative
+ * \f$ \mathbf{J} \mathbf{v} \approx - \left[ \mathbf{r}(\Delta \mathbf{u} + \varepsilon \mathbf{v})
+ * - \mathbf{r}(\Delta \mathbf{u}) \right] / \varepsilon \f$
+ * with the residual at the linearization point passed in once, i.e. every vmult()
+ * costs one residual evaluation and no matrix is stored.
+ *
+ * The direction is made consistent with the constraints before it is applied. The
+ * rows of constrained dofs, which the residual does not contain, act as identity such
+ * that the operator is regular, as the condensed tangent matrix.
+ */
+class JacobianFreeOperator : public Subscriptor
+{
+	public:
+		typedef std::function<void(const Vector<double> &, Vector<double> &)> ResidualFunction;
+
+		/*! @param residual_function Writes the negative residual for a trial increment into its second argument
+		 * @param solution_delta The increment of the linearization point
+		 * @param rhs The negative residual at solution_delta
+		 * @param solution_norm Norm of the total solution, scales the finite difference step
+		 */
+		JacobianFreeOperator(const ResidualFunction &residual_function,
+							const Vector<double> &solution_delta,
+							const Vector<double> &rhs,
+							const double solution_norm,
+							const AffineConstraints<double> &constraints)
+		:
+		residual_function(residual_function),
+		solution_delta(solution_delta),
+		rhs(rhs),
+		solution_norm(solution_norm),
+		constraints(constraints)
+		{}
+
+		void vmult(Vector<double> &dst, const Vector<double> &src) const
+		{
+			//Buffers of the operator, i.e. only the first vmult() allocates them
+			direction = src;
+			constraints.distribute(direction);
+			const double direction_norm = direction.l2_norm();
+			if (direction_norm == 0.)
+			{
+				dst = src;
+				return;
+			}
+			//Step size balancing truncation and round-off error
+			const double epsilon = std::sqrt(std::numeric_limits<double>::epsilon())
+									* (1. + solution_norm) / direction_norm;
+
+			solution_delta_trial = solution_delta;
+			solution_delta_trial.add(epsilon, direction);
+			residual_function(solution_delta_trial, dst);
+			++n_evaluations;
+			dst -= rhs;
+			dst *= -1. / epsilon;
+
+			for (unsigned int i = 0; i < dst.size(); ++i)
+				if (constraints.is_constrained(i))
+					dst(i) = src(i);
+		}
+		/*! Number of residual evaluations, i.e. of calls of vmult()
+		 */
+		unsigned int n_residual_evaluations() const
+		{
+			return n_evaluations;
+		}
+
+	private:
+		const ResidualFunction           residual_function;
+		const Vector<double>            &solution_delta;
+		const Vector<double>            &rhs;
+		const double                     solution_norm;
+		const AffineConstraints<double> &constraints;
+		mutable unsigned int             n_evaluations = 0;
+		mutable Vector<double>           direction;
+		mutable Vector<double>           solution_delta_trial;
+};
+
+#endif
@@ -8,6 +8,7 @@
 #include <deal.II/physics/elasticity/standard_tensors.h>
 
 #include "StrainMeasures.h"
+#include "IsotropicTangent.h"
 
 #include <iostream>
 
@@ -44,6 +45,12 @@ using namespace dealii;
 * Tensor<2,dim> Sigma;
 * Sigma = Material.get_CauchyStress(DefoGrad) ;
 * ~~~~~~~~~~~~~~~~~~~~~~ 
+*
+* The number type is a template parameter. With Number = VectorizedArray<double>
+* evaluate() computes the quantities of several quadrature points at once, one per
+* lane; a non-positive determinant is then reported lane-wise in
+* Evaluation::invalid_lanes instead of throwing. The separate getters keep the
+* throwing check and are meant for Number = double.
 */
 
 //Declaration of the class template
@@ -53,7 +60,7 @@ using namespace dealii;
  * using a 2nd order tensor, i.e. the deformation gradient,
  * as input
  */
-template<int dim>
+template<int dim, typename Number = double>
 class NeoHookeanMaterial 
 {
     public:
@@ -73,13 +80,13 @@ class NeoHookeanMaterial
 		 * = J \boldsymbol{\sigma} \f$
 		 * @return The Kirchhoff stress \f$ \boldsymbol{\tau}\f$
 		 */				
-        SymmetricTensor<2, dim> get_KirchhoffStress(const Tensor<2, dim> &F) ;
+        SymmetricTensor<2, dim, Number> get_KirchhoffStress(const Tensor<2, dim, Number> &F) ;
 		 /*! A function to compute and return the \f$ 2^{\text{nd}}\f$ Piola-Kirchhoff stress
 		 * \f$ \mathbf{S} =  J \mathbf{F}^{-1} \cdot \boldsymbol{\sigma} 
 		 * \cdot \mathbf{F}^{-t} \f$
 		 * @return \f$ 2^{\text{nd}}\f$ Piola-Kirchhoff stress \f$ \mathbf{S} \f$
 		 */	
-		SymmetricTensor<2, dim> get_2ndPiolaKirchhoffStress(const Tensor<2, dim> &F);
+		SymmetricTensor<2, dim, Number> get_2ndPiolaKirchhoffStress(const Tensor<2, dim, Number> &F);
 				
         /*! A function to compute and return the Cauchy stress
 		 * \f$ \boldsymbol{\sigma} =  \frac{\mu}{J} \left[ \mathbf{b} - \mathbf{I} \right]
@@ -87,14 +94,64 @@ class NeoHookeanMaterial
 		 * , with \f$ \mathbf{b} = \mathbf{F} \cdot \mathbf{F}^t\f$
 		 * @return Cauchy stress \f$ \boldsymbol{\sigma} \f$
 		 */		
-        SymmetricTensor<2, dim> get_CauchyStress(const Tensor<2, dim> &F) ;
+        SymmetricTensor<2, dim, Number> get_CauchyStress(const Tensor<2, dim, Number> &F) ;
 		/*! A function to compute and return the Piola stress
 		 * \f$ \mathbf{P} =  J \cdot \boldsymbol{\sigma} \cdot \mathbf{F}^{-t}\f$
 		 * @return Piola stress \f$ \mathbf{P} \f$
 		 */			
-        Tensor<2, dim> get_PiolaStress(const Tensor<2, dim> &F) ;
+        Tensor<2, dim, Number> get_PiolaStress(const Tensor<2, dim, Number> &F) ;
 		
-		SymmetricTensor<4, dim> get_Tangent_spt(const Tensor<2, dim> &F) ;
+		SymmetricTensor<4, dim, Number> get_Tangent_spt(const Tensor<2, dim, Number> &F) ;
+		/*! A function to compute and return the strain energy density
+		 * \f$ \Psi^{NH} = \frac{\mu}{2} \left[ I_C - \text{dim} \right] -
+		 * \mu {ln}\left( J\right) + \frac{\lambda}{2} {ln}^2 \left( J \right) \f$,
+		 * which equals the one above for plane strain in 2D
+		 * @return Strain energy density \f$ \Psi^{NH} \f$
+		 */
+		Number get_StrainEnergy(const Tensor<2, dim, Number> &F) const;
+
+		/*! All quantities needed at a quadrature point of the Newton-Raphson
+		 * assembly, computed together by evaluate()
+		 */
+		struct Evaluation
+		{
+			/*! \f$ J = \text{det}\left( \mathbf{F} \right) \f$ */
+			Number det_F;
+			/*! \f$ \text{ln}\left( J \right) \f$ */
+			Number ln_det_F;
+			/*! \f$ \mathbf{F}^{-1} \f$ */
+			Tensor<2, dim, Number> F_inv;
+			/*! Kirchhoff stress \f$ \boldsymbol{\tau} \f$ */
+			SymmetricTensor<2, dim, Number> KirchhoffStress;
+			/*! Spatial tangent as returned by get_Tangent_spt(), only
+			 * computed on request */
+			SymmetricTensor<4, dim, Number> Tangent_spt;
+			/*! Spatial tangent \f$ \lambda \, \mathbf{I} \otimes \mathbf{I}
+			 * + 2 \left[ \mu - \lambda \text{ln}\left( J \right) \right] \mathbb{S} \f$
+			 * in its structured isotropic form */
+			IsotropicTangent<dim, Number> Tangent_iso;
+			/*! Bit l is set if \f$ J \leq 0 \f$ in lane l of a VectorizedArray, these
+			 * lanes hold the quantities of F = I. Always zero for Number = double, where
+			 * evaluate() throws instead */
+			unsigned int invalid_lanes = 0;
+		};
+		/*! The spatial tangent of this material is of the form of IsotropicTangent,
+		 * i.e. Evaluation::Tangent_iso can be used instead of Evaluation::Tangent_spt
+		 */
+		static const bool has_isotropic_tangent = true;
+		/*! A function to compute \f$ J \f$, \f$ \text{ln}\left( J \right) \f$,
+		 * \f$ \mathbf{F}^{-1} \f$, the Kirchhoff stress
+		 * \f$ \boldsymbol{\tau} = \mu \left[ \mathbf{b} - \mathbf{I} \right]
+		 * + \lambda \text{ln}\left( J \right) \mathbf{I} \f$
+		 * and the spatial tangent in one call. Quantities shared by stress
+		 * and tangent, e.g. the determinant and its logarithm, are computed once
+		 * @param F Deformation gradient
+		 * @param result The computed quantities
+		 * @param compute_Tangent_spt Also form the SymmetricTensor<4,dim>
+		 * Evaluation::Tangent_spt besides Evaluation::Tangent_iso
+		 */
+		void evaluate(const Tensor<2, dim, Number> &F, Evaluation &result,
+					const bool compute_Tangent_spt = true) const;
     protected:
 
     private:
@@ -115,8 +172,8 @@ class NeoHookeanMaterial
 //-----------------------------------------------------------
 //-----------------------------------------------------------
 //-----------------------------------------------------------
-template <int dim> //Constructor
-NeoHookeanMaterial<dim>::NeoHookeanMaterial(double mu, double lambda)
+template <int dim, typename Number> //Constructor
+NeoHookeanMaterial<dim, Number>::NeoHookeanMaterial(double mu, double lambda)
 :
 mu(mu),
 lambda(lambda)
@@ -130,8 +187,8 @@ lambda(lambda)
 
 
 //------------------------------------------
-template <int dim>
-SymmetricTensor<2, dim> NeoHookeanMaterial<dim>::get_CauchyStress(const Tensor<2, dim> &F)
+template <int dim, typename Number>
+SymmetricTensor<2, dim, Number> NeoHookeanMaterial<dim, Number>::get_CauchyStress(const Tensor<2, dim, Number> &F)
 {
 	/* Implement a routine to compute the Cauchy stress using 
 	 * the function "get_LeftCauchyGreenTensor" and the unit
@@ -145,10 +202,10 @@ SymmetricTensor<2, dim> NeoHookeanMaterial<dim>::get_CauchyStress(const Tensor<2
 	 * in order to compute the determinant of the deformation gradient
 	 * since it contains a check to see if its value is greater zero.
 	 */ 
-	SymmetricTensor<2,dim> CauchyStress;
+	SymmetricTensor<2,dim,Number> CauchyStress;
 	
 	//BEGIN - INSERT YOUR CODE HERE
-	double det_F = StrainMeasures::get_DeterminantDefoGrad(F);
+	Number det_F = StrainMeasures::get_DeterminantDefoGrad(F);
 	CauchyStress = (   (mu/det_F)*(StrainMeasures::get_LeftCauchyGreenTensor(F)
 		- Physics::Elasticity::StandardTensors<dim>::I)
 		+ ( ((lambda * std::log(det_F))/det_F ) * Physics::Elasticity::StandardTensors<dim>::I)  );
@@ -161,8 +218,8 @@ SymmetricTensor<2, dim> NeoHookeanMaterial<dim>::get_CauchyStress(const Tensor<2
 
 //------------------------------------------
 
-template <int dim>
-Tensor<2, dim> NeoHookeanMaterial<dim>::get_PiolaStress(const Tensor<2, dim> &F)
+template <int dim, typename Number>
+Tensor<2, dim, Number> NeoHookeanMaterial<dim, Number>::get_PiolaStress(const Tensor<2, dim, Number> &F)
 {
 	/*
 	 * Compute the Piola stress based on the cauchy stress.
@@ -174,12 +231,12 @@ Tensor<2, dim> NeoHookeanMaterial<dim>::get_PiolaStress(const Tensor<2, dim> &F)
 	 * Therefore the "static_cast" operator is used to transform
 	 * the SymmetricTensor to a regular 2nd order tensor.
 	 */
-	Tensor<2,dim> PiolaStress;
-    Tensor<2,dim> CauchyStress = static_cast<Tensor<2,dim> > ( get_CauchyStress(F) );
+	Tensor<2,dim,Number> PiolaStress;
+    Tensor<2,dim,Number> CauchyStress = static_cast<Tensor<2,dim,Number> > ( get_CauchyStress(F) );
 
 	//BEGIN - INSERT YOUR CODE HERE
-	double det_F = StrainMeasures::get_DeterminantDefoGrad(F);
-	Tensor<2,dim> F_inv = invert(F);
+	Number det_F = StrainMeasures::get_DeterminantDefoGrad(F);
+	Tensor<2,dim,Number> F_inv = invert(F);
 	PiolaStress = det_F * CauchyStress * (transpose(F_inv));
 	
 	
@@ -189,19 +246,19 @@ Tensor<2, dim> NeoHookeanMaterial<dim>::get_PiolaStress(const Tensor<2, dim> &F)
 	
 }
 
-template <int dim>
-SymmetricTensor<2, dim> NeoHookeanMaterial<dim>::get_2ndPiolaKirchhoffStress(const Tensor<2, dim> &F)
+template <int dim, typename Number>
+SymmetricTensor<2, dim, Number> NeoHookeanMaterial<dim, Number>::get_2ndPiolaKirchhoffStress(const Tensor<2, dim, Number> &F)
 {
 	/* Implement a routine to compute the 2nd PiolaKirchhoff stress using 
 	 * the function "get_CauchyStress" and the "static_cast<Tensor<2,dim>> 
 	 * similar to the previous example.
 	 */ 
-    SymmetricTensor<2,dim> SecPiolaKirchhoffStress;
+    SymmetricTensor<2,dim,Number> SecPiolaKirchhoffStress;
 
 	//BEGIN - INSERT YOUR CODE HERE
-	double det_F = StrainMeasures::get_DeterminantDefoGrad(F);
-	Tensor<2,dim> F_inv = invert(F);
-	SecPiolaKirchhoffStress =  symmetrize(  det_F * F_inv * static_cast<Tensor<2,dim> >( get_CauchyStress(F)) * transpose (F_inv) );
+	Number det_F = StrainMeasures::get_DeterminantDefoGrad(F);
+	Tensor<2,dim,Number> F_inv = invert(F);
+	SecPiolaKirchhoffStress =  symmetrize(  det_F * F_inv * static_cast<Tensor<2,dim,Number> >( get_CauchyStress(F)) * transpose (F_inv) );
 	
 	
     //END - INSERT YOUR CODE HERE	
@@ -211,15 +268,15 @@ SymmetricTensor<2, dim> NeoHookeanMaterial<dim>::get_2ndPiolaKirchhoffStress(con
 }
 
 //------------------------------------------
-template <int dim>
-SymmetricTensor<2, dim> NeoHookeanMaterial<dim>::get_KirchhoffStress(const Tensor<2, dim> &F)
+template <int dim, typename Number>
+SymmetricTensor<2, dim, Number> NeoHookeanMaterial<dim, Number>::get_KirchhoffStress(const Tensor<2, dim, Number> &F)
 {
 	/* This function returns the Kirchhoff stress "tau".
 	* Use the already available function "get_CauchyStress"
 	* in order to compute this quantity.
 	*/
 	
-	SymmetricTensor<2,dim> KirchhoffStress;
+	SymmetricTensor<2,dim,Number> KirchhoffStress;
 	
 	//BEGIN - INSERT YOUR CODE HERE
 	KirchhoffStress = get_CauchyStress(F) * StrainMeasures::get_DeterminantDefoGrad(F);
@@ -232,14 +289,54 @@ SymmetricTensor<2, dim> NeoHookeanMaterial<dim>::get_KirchhoffStress(const Tenso
 
 //------------------------------------------
 
-template <int dim>
-SymmetricTensor<4, dim> NeoHookeanMaterial<dim>::get_Tangent_spt(const Tensor<2, dim> &F)
+template <int dim, typename Number>
+SymmetricTensor<4, dim, Number> NeoHookeanMaterial<dim, Number>::get_Tangent_spt(const Tensor<2, dim, Number> &F)
 {
-	double det_F = StrainMeasures::get_DeterminantDefoGrad(F);
+	Number det_F = StrainMeasures::get_DeterminantDefoGrad(F);
     return ( ( (lambda/det_F)*Physics::Elasticity::StandardTensors<dim>::IxI
 	 + 2*( (mu-(lambda*std::log(det_F)))/ det_F  )*Physics::Elasticity::StandardTensors<dim>::S   )
 		* det_F);
 }
+//------------------------------------------
+
+template <int dim, typename Number>
+Number NeoHookeanMaterial<dim, Number>::get_StrainEnergy(const Tensor<2, dim, Number> &F) const
+{
+	const Number ln_det_F = std::log(StrainMeasures::get_DeterminantDefoGrad(F));
+	return ( 0.5 * mu * (trace(StrainMeasures::get_RightCauchyGreenTensor(F)) - dim)
+			- mu * ln_det_F + 0.5 * lambda * ln_det_F * ln_det_F );
+}
+//------------------------------------------
+
+template <int dim, typename Number>
+void NeoHookeanMaterial<dim, Number>::evaluate(const Tensor<2, dim, Number> &F, Evaluation &result,
+										const bool compute_Tangent_spt) const
+{
+	//The material parameters in all lanes, such that only tensors of Number are combined
+	const Number mu_number = StrainMeasures::make_number<Number>(mu);
+	const Number lambda_number = StrainMeasures::make_number<Number>(lambda);
+	const SymmetricTensor<2, dim, Number> I = unit_symmetric_tensor<dim, Number>();
+
+	result.det_F = StrainMeasures::get_DeterminantDefoGrad(F, result.invalid_lanes);
+	if (result.invalid_lanes != 0)
+	{
+		//Invert and evaluate the invalid lanes at F = I instead, such that no lane holds inf or NaN
+		const unsigned int invalid_lanes = result.invalid_lanes;
+		evaluate(StrainMeasures::get_DefoGradWithIdentityInLanes(F, invalid_lanes), result, compute_Tangent_spt);
+		result.invalid_lanes = invalid_lanes;
+		return;
+	}
+	result.ln_det_F = std::log(result.det_F);
+	result.F_inv = invert(F);
+	result.KirchhoffStress = mu_number * (StrainMeasures::get_LeftCauchyGreenTensor(F) - I)
+							+ (lambda_number * result.ln_det_F) * I;
+	result.Tangent_iso = IsotropicTangent<dim, Number>(lambda_number,
+														2. * (mu_number - lambda_number * result.ln_det_F));
+	if (compute_Tangent_spt)
+	{
+		result.Tangent_spt = result.Tangent_iso.get_SymmetricTensor();
+	}
+}
 //END PUBLIC MEMBER FUNCTIONS
 //----------------------------------------------------------------------------
 
@@ -0,0 +1,348 @@
+#ifndef NEOHOOKEANOPERATOR_H
+#define NEOHOOKEANOPERATOR_H
+
+#include <deal.II/base/aligned_vector.h>
+#include <deal.II/base/quadrature_lib.h>
+#include <deal.II/base/subscriptor.h>
+#include <deal.II/base/symmetric_tensor.h>
+#include <deal.II/base/table.h>
+#include <deal.II/base/tensor.h>
+#include <deal.II/base/vectorization.h>
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/lac/affine_constraints.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
+#include <deal.II/matrix_free/matrix_free.h>
+#include <deal.II/physics/elasticity/standard_tensors.h>
+
+#include "NeoHookeanMaterial.h"
+
+#include <memory>
+#include <stdexcept>
+
+using namespace dealii;
+
+/*! \brief Matrix-free application of the linearised Neo-Hookean operator
+ *
+ * The tangent \f$ \mathbf{K} \f$ of the Newton-Raphson scheme is never stored.
+ * Instead its action \f$ \mathbf{K} \Delta \mathbf{u} \f$ is computed cell by cell
+ * with sum-factorisation (FEEvaluation). The quantities of the linearisation point,
+ * i.e. \f$ \mathbf{F}^{-1} \f$, the Kirchhoff stress \f$ \boldsymbol{\tau} \f$ and
+ * the spatial tangent, are computed once per Newton iteration with NeoHookeanMaterial
+ * and cached for every quadrature point.
+ *
+ * The class is used through the interface NeoHookeanOperatorBase such that the
+ * polynomial degree, which is a template parameter of FEEvaluation, can be chosen
+ * at runtime with create_NeoHookeanOperator().
+ */
+template <int dim>
+class NeoHookeanOperatorBase : public Subscriptor
+{
+	public:
+		virtual ~NeoHookeanOperatorBase(){}
+		/*! Set up the MatrixFree data structures. Has to be called again whenever the
+		 * constraints change
+		 */
+		virtual void initialize(const DoFHandler<dim> &dof_handler,
+								const AffineConstraints<double> &constraints) = 0;
+		/*! Compute and store the stress and tangent at all quadrature points for
+		 * the total displacement \f$ \mathbf{u} \f$
+		 */
+		virtual void set_linearization_point(const Vector<double> &solution_total) = 0;
+		/*! dst = K * src; constrained entries are copied from src
+		 */
+		virtual void vmult(Vector<double> &dst, const Vector<double> &src) const = 0;
+		/*! The tangent is symmetric, i.e. Tvmult equals vmult
+		 */
+		void Tvmult(Vector<double> &dst, const Vector<double> &src) const
+		{
+			vmult(dst, src);
+		}
+		/*! Compute and store the diagonal of K without assembling K, used for the
+		 * Jacobi and Chebyshev preconditioners
+		 */
+		virtual void compute_diagonal() = 0;
+		/*! The diagonal as computed by the last call of compute_diagonal()
+		 */
+		const Vector<double> &get_diagonal() const
+		{
+			return diagonal_entries;
+		}
+		/*! Only the diagonal entries are available; PreconditionChebyshev
+		 * queries them if no preconditioner is handed over
+		 */
+		double el(const types::global_dof_index row, const types::global_dof_index col) const
+		{
+			Assert(row == col, ExcNotImplemented());
+			(void)col;
+			return diagonal_entries(row);
+		}
+
+		virtual types::global_dof_index m() const = 0;
+
+		types::global_dof_index n() const
+		{
+			return m();
+		}
+
+		virtual std::size_t memory_consumption() const = 0;
+
+	protected:
+		Vector<double> diagonal_entries;
+};
+
+
+
+
+template <int dim, int fe_degree, int n_q_points_1d>
+class NeoHookeanOperator : public NeoHookeanOperatorBase<dim>
+{
+	public:
+		/*! @param mu The Lame parameter \f$ \mu \f$
+		 * @param lambda The Lame parameter \f$ \lambda \f$
+		 */
+		NeoHookeanOperator(double mu, double lambda);
+
+		void initialize(const DoFHandler<dim> &dof_handler,
+						const AffineConstraints<double> &constraints) override;
+
+		void set_linearization_point(const Vector<double> &solution_total) override;
+
+		void vmult(Vector<double> &dst, const Vector<double> &src) const override;
+
+		void compute_diagonal() override;
+
+		types::global_dof_index m() const override;
+
+		std::size_t memory_consumption() const override;
+
+	private:
+		typedef FEEvaluation<dim, fe_degree, n_q_points_1d, dim, double> FECellIntegrator;
+
+		/*! Cell loop body of vmult() for a range of cell batches
+		 */
+		void local_apply(const MatrixFree<dim, double> &mf_data,
+						Vector<double> &dst,
+						const Vector<double> &src,
+						const std::pair<unsigned int, unsigned int> &cell_range) const;
+		/*! Replace the gradients of phi at all quadrature points by the
+		 * linearised first Piola stress, i.e.
+		 * \f$ \left[ \mathbb{c} : \text{sym}\left( \nabla_x \Delta \mathbf{u} \right)
+		 * + \nabla_x \Delta \mathbf{u} \cdot \boldsymbol{\tau} \right] \cdot \mathbf{F}^{-t} \f$
+		 */
+		void do_quadrature_point_operations(FECellIntegrator &phi,
+											const unsigned int cell) const;
+
+		MatrixFree<dim, double> data;
+
+		/*! Evaluated for all lanes of a cell batch at once */
+		NeoHookeanMaterial<dim, VectorizedArray<double> > material;
+
+		//Cached values of the linearisation point, indexed by (cell batch, quadrature point)
+		Table<2, Tensor<2, dim, VectorizedArray<double> > >          F_inv_qp;
+		Table<2, SymmetricTensor<2, dim, VectorizedArray<double> > > tau_qp;
+		Table<2, IsotropicTangent<dim, VectorizedArray<double> > >   tangent_qp;
+};
+
+
+
+
+/*! Create a NeoHookeanOperator for the runtime polynomial degree of the
+ * finite element. Only the 2 point Gauss rule per direction, as used in
+ * the assembled version, is instantiated.
+ */
+template <int dim>
+std::unique_ptr<NeoHookeanOperatorBase<dim> >
+create_NeoHookeanOperator(const unsigned int fe_degree,
+						const unsigned int n_q_points_1d,
+						const double mu,
+						const double lambda)
+{
+	AssertThrow(n_q_points_1d == 2,
+				ExcMessage("Matrix-free operator only instantiated for 2 Gauss points per direction"));
+	switch (fe_degree)
+	{
+		case 1:
+			return std::make_unique<NeoHookeanOperator<dim, 1, 2> >(mu, lambda);
+		case 2:
+			return std::make_unique<NeoHookeanOperator<dim, 2, 2> >(mu, lambda);
+		case 3:
+			return std::make_unique<NeoHookeanOperator<dim, 3, 2> >(mu, lambda);
+		case 4:
+			return std::make_unique<NeoHookeanOperator<dim, 4, 2> >(mu, lambda);
+		default:
+			AssertThrow(false,
+						ExcMessage("Matrix-free operator only instantiated for degree 1 to 4"));
+	}
+	return nullptr;
+}
+
+
+
+
+//Definition of the class template
+//-----------------------------------------------------------
+//-----------------------------------------------------------
+template <int dim, int fe_degree, int n_q_points_1d>
+NeoHookeanOperator<dim, fe_degree, n_q_points_1d>::NeoHookeanOperator(double mu, double lambda)
+:
+material(mu, lambda)
+{
+}
+
+
+
+template <int dim, int fe_degree, int n_q_points_1d>
+void NeoHookeanOperator<dim, fe_degree, n_q_points_1d>::initialize(const DoFHandler<dim> &dof_handler,
+																	const AffineConstraints<double> &constraints)
+{
+	typename MatrixFree<dim, double>::AdditionalData additional_data;
+	additional_data.mapping_update_flags = (update_gradients | update_JxW_values);
+	data.reinit(dof_handler, constraints, QGauss<1>(n_q_points_1d), additional_data);
+
+	const FECellIntegrator phi(data);
+	F_inv_qp.reinit(data.n_macro_cells(), phi.n_q_points);
+	tau_qp.reinit(data.n_macro_cells(), phi.n_q_points);
+	tangent_qp.reinit(data.n_macro_cells(), phi.n_q_points);
+}
+
+
+
+template <int dim, int fe_degree, int n_q_points_1d>
+void NeoHookeanOperator<dim, fe_degree, n_q_points_1d>::set_linearization_point(const Vector<double> &solution_total)
+{
+	FECellIntegrator phi(data);
+	const VectorizedArray<double> one = StrainMeasures::make_number<VectorizedArray<double> >(1.);
+	for (unsigned int cell = 0; cell < data.n_macro_cells(); ++cell)
+	{
+		phi.reinit(cell);
+		//The total solution already fulfills the constraints, i.e. read it without resolving them
+		phi.read_dof_values_plain(solution_total);
+		phi.evaluate(false, true);
+		for (unsigned int q = 0; q < phi.n_q_points; ++q)
+		{
+			//Empty lanes of the last cell batch have a zero gradient, i.e. F = I
+			Tensor<2, dim, VectorizedArray<double> > DeformationGradient = phi.get_gradient(q);
+			for (unsigned int d = 0; d < dim; ++d)
+				DeformationGradient[d][d] += one;
+
+			typename NeoHookeanMaterial<dim, VectorizedArray<double> >::Evaluation material_point;
+			material.evaluate(DeformationGradient, material_point, false);
+			if (material_point.invalid_lanes != 0)
+				throw StrainMeasures::InvalidDeformation();
+
+			F_inv_qp(cell, q) = material_point.F_inv;
+			tau_qp(cell, q) = material_point.KirchhoffStress;
+			tangent_qp(cell, q) = material_point.Tangent_iso;
+		}
+	}
+}
+
+
+
+template <int dim, int fe_degree, int n_q_points_1d>
+void NeoHookeanOperator<dim, fe_degree, n_q_points_1d>::do_quadrature_point_operations(FECellIntegrator &phi,
+																						const unsigned int cell) const
+{
+	for (unsigned int q = 0; q < phi.n_q_points; ++q)
+	{
+		const Tensor<2, dim, VectorizedArray<double> > &F_inv = F_inv_qp(cell, q);
+		//Gradient of the ansatz function with respect to the spatial configuration
+		const Tensor<2, dim, VectorizedArray<double> > grad_spt = phi.get_gradient(q) * F_inv;
+		//Material contribution c:sym(grad) plus geometrical contribution grad*tau
+		const Tensor<2, dim, VectorizedArray<double> > stress_increment =
+			static_cast<Tensor<2, dim, VectorizedArray<double> > >(tangent_qp(cell, q) * symmetrize(grad_spt))
+			+ grad_spt * static_cast<Tensor<2, dim, VectorizedArray<double> > >(tau_qp(cell, q));
+		//Pull back to the reference configuration, which the test gradient refers to
+		phi.submit_gradient(stress_increment * transpose(F_inv), q);
+	}
+}
+
+
+
+template <int dim, int fe_degree, int n_q_points_1d>
+void NeoHookeanOperator<dim, fe_degree, n_q_points_1d>::local_apply(const MatrixFree<dim, double> &mf_data,
+																	Vector<double> &dst,
+																	const Vector<double> &src,
+																	const std::pair<unsigned int, unsigned int> &cell_range) const
+{
+	FECellIntegrator phi(mf_data);
+	for (unsigned int cell = cell_range.first; cell < cell_range.second; ++cell)
+	{
+		phi.reinit(cell);
+		phi.read_dof_values(src);
+		phi.evaluate(false, true);
+		do_quadrature_point_operations(phi, cell);
+		phi.integrate(false, true);
+		phi.distribute_local_to_global(dst);
+	}
+}
+
+
+
+template <int dim, int fe_degree, int n_q_points_1d>
+void NeoHookeanOperator<dim, fe_degree, n_q_points_1d>::vmult(Vector<double> &dst,
+															const Vector<double> &src) const
+{
+	data.cell_loop(&NeoHookeanOperator::local_apply, this, dst, src, true);
+	//Identity on the constrained dofs, in line with the diagonal entries that
+	//AffineConstraints::distribute_local_to_global writes into the assembled matrix
+	for (const unsigned int i : data.get_constrained_dofs())
+		dst(i) = src(i);
+}
+
+
+
+template <int dim, int fe_degree, int n_q_points_1d>
+void NeoHookeanOperator<dim, fe_degree, n_q_points_1d>::compute_diagonal()
+{
+	Vector<double> &diagonal = this->diagonal_entries;
+	diagonal.reinit(m());
+
+	FECellIntegrator phi(data);
+	AlignedVector<VectorizedArray<double> > local_diagonal(phi.dofs_per_cell);
+	for (unsigned int cell = 0; cell < data.n_macro_cells(); ++cell)
+	{
+		phi.reinit(cell);
+		//Apply the cell operator to all unit vectors and keep the i-th entry
+		for (unsigned int i = 0; i < phi.dofs_per_cell; ++i)
+		{
+			for (unsigned int j = 0; j < phi.dofs_per_cell; ++j)
+				phi.begin_dof_values()[j] = 0.;
+			phi.begin_dof_values()[i] = 1.;
+			phi.evaluate(false, true);
+			do_quadrature_point_operations(phi, cell);
+			phi.integrate(false, true);
+			local_diagonal[i] = phi.begin_dof_values()[i];
+		}
+		for (unsigned int i = 0; i < phi.dofs_per_cell; ++i)
+			phi.begin_dof_values()[i] = local_diagonal[i];
+		phi.distribute_local_to_global(diagonal);
+	}
+
+	for (const unsigned int i : data.get_constrained_dofs())
+		diagonal(i) = 1.0;
+}
+
+
+
+template <int dim, int fe_degree, int n_q_points_1d>
+types::global_dof_index NeoHookeanOperator<dim, fe_degree, n_q_points_1d>::m() const
+{
+	return data.get_dof_handler().n_dofs();
+}
+
+
+
+template <int dim, int fe_degree, int n_q_points_1d>
+std::size_t NeoHookeanOperator<dim, fe_degree, n_q_points_1d>::memory_consumption() const
+{
+	return (data.memory_consumption()
+			+ this->diagonal_entries.memory_consumption()
+			+ F_inv_qp.memory_consumption()
+			+ tau_qp.memory_consumption()
+			+ tangent_qp.memory_consumption());
+}
+//----------------------------------------------------------------------------
+
+#endif
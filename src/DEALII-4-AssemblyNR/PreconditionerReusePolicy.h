@@ -0,0 +1,105 @@
+#ifndef PRECONDITIONERREUSEPOLICY_H
+#define PRECONDITIONERREUSEPOLICY_H
+
+#include <cmath>
+#include <string>
+
+/*! \brief Decides whether a preconditioner (or factorization) set up for an earlier
+ * tangent is kept for the next linear solve or rebuilt
+ *
+ * The preconditioner is rebuilt if
+ * - it was never built or has been invalidated, e.g. after the system setup,
+ * - a new load step starts (if rebuild_each_load_step),
+ * - the last solve needed more than max_iterations iterations,
+ * - the residual reduction per iteration of the last solve dropped by more than the
+ *   factor max_rate_deterioration compared to the first solve after the last rebuild.
+ *
+ * Before each solve decide() is called; after the solve the iteration count and the
+ * residuals are passed to record_solve(). The reason of every decision is kept in
+ * get_reason() such that it can be logged.
+ */
+class PreconditionerReusePolicy
+{
+	public:
+		/*! Force a rebuild before the next solve
+		 */
+		void invalidate()
+		{
+			valid = false;
+		}
+		/*! A new load step starts: reset the counters and, if requested, force a rebuild
+		 */
+		void new_load_step()
+		{
+			n_rebuilds = 0;
+			n_reuses = 0;
+			if (rebuild_each_load_step)
+				rebuild_load_step = true;
+		}
+		/*! @return true if the preconditioner has to be rebuilt before the next solve
+		 */
+		bool decide()
+		{
+			if (!valid)
+				reason = "not built";
+			else if (rebuild_load_step)
+				reason = "new load step";
+			else if (rebuild_iterations)
+				reason = "iterations";
+			else if (rebuild_rate)
+				reason = "reduction rate";
+			else
+			{
+				reason = "reuse";
+				++n_reuses;
+				return false;
+			}
+			valid = true;
+			rebuild_load_step = rebuild_iterations = rebuild_rate = false;
+			reference_rate = 0.;
+			++n_rebuilds;
+			return true;
+		}
+		/*! Store the statistics of the solve the decision was made for
+		 */
+		void record_solve(const unsigned int n_iterations,
+						const double initial_residual,
+						const double final_residual)
+		{
+			rebuild_iterations = (n_iterations > max_iterations);
+			if (n_iterations == 0 || initial_residual <= 0. || final_residual <= 0.)
+				return;
+			//Average order of magnitude the residual is reduced by per iteration
+			const double rate = std::log10(initial_residual / final_residual) / n_iterations;
+			if (reference_rate == 0.)
+				reference_rate = rate;
+			else
+				rebuild_rate = (rate * max_rate_deterioration < reference_rate);
+		}
+		const std::string &get_reason() const
+		{
+			return reason;
+		}
+
+		//member variables
+		/*! Rebuild if a solve needs more iterations */
+		unsigned int max_iterations = 50;
+		/*! Rebuild if the reduction per iteration falls below the one after the
+		 * last rebuild divided by this factor */
+		double max_rate_deterioration = 2.;
+		/*! Rebuild at the first solve of every load step */
+		bool rebuild_each_load_step = true;
+		/*! Number of rebuilds and reuses within the current load step */
+		unsigned int n_rebuilds = 0;
+		unsigned int n_reuses = 0;
+
+	private:
+		bool valid = false;
+		bool rebuild_load_step = false;
+		bool rebuild_iterations = false;
+		bool rebuild_rate = false;
+		double reference_rate = 0.;
+		std::string reason;
+};
+
+#endif
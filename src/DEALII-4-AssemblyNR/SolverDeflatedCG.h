@@ -0,0 +1,263 @@
+#ifndef SOLVERDEFLATEDCG_H
+#define SOLVERDEFLATEDCG_H
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/lac/full_matrix.h>
+#include <deal.II/lac/solver_control.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/lac/vector_memory.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace dealii;
+
+/*! \brief Orthonormal basis of the solutions of the previous linear solves
+ *
+ * The Newton updates of neighbouring iterations and load steps are dominated by the
+ * same smooth deformation modes, which are the slowly converging modes of CG. The
+ * last max_dimension solutions are kept, orthonormalised, as the deflation space of
+ * SolverDeflatedCG. Once max_dimension vectors are stored, a new one takes over the
+ * storage of the oldest one, i.e. add() no longer allocates.
+ */
+class RecyclingSubspace
+{
+	public:
+		/*! Add a solution; dropped if it is (nearly) contained in the basis already.
+		 * The oldest vector is removed once max_dimension is exceeded
+		 */
+		void add(const Vector<double> &solution)
+		{
+			w = solution;
+			const double norm_0 = w.l2_norm();
+			if (norm_0 == 0.)
+				return;
+			//Modified Gram-Schmidt, twice for stability
+			for (unsigned int pass = 0; pass < 2; ++pass)
+				for (const Vector<double> &v : basis)
+					w.add(-(v * w), v);
+			const double norm = w.l2_norm();
+			if (norm < 1e-8 * norm_0)
+				return;
+			w /= norm;
+			if (basis.size() < max_dimension)
+			{
+				basis.reserve(max_dimension);
+				basis.push_back(w);
+			}
+			else if (max_dimension > 0)
+			{
+				//The oldest vector moves to the back and is replaced by w, the vectors
+				//only exchange their storage
+				std::rotate(basis.begin(), basis.begin() + 1, basis.end());
+				basis.back().swap(w);
+			}
+		}
+		void clear()
+		{
+			basis.clear();
+			w.reinit(0);
+		}
+		/*! The basis vectors, the oldest first
+		 */
+		const std::vector<Vector<double> > &get_basis() const
+		{
+			return basis;
+		}
+
+		//member variables
+		unsigned int max_dimension = 8;
+
+	private:
+		std::vector<Vector<double> > basis;
+		/*! The vector being orthonormalised by add() */
+		Vector<double>               w;
+};
+
+
+
+/*! \brief Buffers of SolverDeflatedCG kept across solves
+ *
+ * A solver object is created for every linear system. With the buffers of the
+ * deflation setup kept here, a solve with a deflation space of the size of the
+ * previous one does not allocate.
+ */
+struct DeflationWorkspace
+{
+	/*! The products of the matrix with the basis vectors */
+	std::vector<Vector<double> > AW;
+	/*! \f$ \mathbf{E}^{-1} \f$ */
+	FullMatrix<double>           E_inv;
+	/*! (AW)^T v of the projection, its product with E_inv, and W^T b */
+	Vector<double>               AW_v;
+	Vector<double>               mu;
+	Vector<double>               Wt_b;
+};
+
+
+
+/*! \brief Deflated preconditioned CG
+ *
+ * For a deflation space \f$ \mathbf{W} \f$ the initial guess is the Galerkin solution
+ * \f$ \mathbf{x}_0 = \mathbf{W} \mathbf{E}^{-1} \mathbf{W}^T \mathbf{b} \f$ with
+ * \f$ \mathbf{E} = \mathbf{W}^T \mathbf{A} \mathbf{W} \f$, and all search directions are
+ * kept A-orthogonal to \f$ \mathbf{W} \f$ (Saad, Yeung, Erhel, Guyomarc'h 2000), i.e. the
+ * modes in \f$ \mathbf{W} \f$ are removed from the iteration. Without a deflation space
+ * this is plain preconditioned CG. The setup costs one matrix-vector product per basis
+ * vector, each iteration one inner product and one vector update per basis vector more
+ * than CG.
+ *
+ * The interface follows the deal.II solvers, convergence is checked by the SolverControl.
+ * The work vectors of the iteration are taken from a GrowingVectorMemory and those of
+ * the deflation setup from the DeflationWorkspace, i.e. only a larger deflation space
+ * than in the previous solve allocates.
+ */
+class SolverDeflatedCG
+{
+	public:
+		SolverDeflatedCG(SolverControl &solver_control,
+						const std::vector<Vector<double> > &basis,
+						DeflationWorkspace &workspace)
+		:
+		solver_control(solver_control),
+		basis(basis),
+		workspace(workspace)
+		{}
+
+		template <typename MatrixType, typename PreconditionerType>
+		void solve(const MatrixType &A,
+					Vector<double> &x,
+					const Vector<double> &b,
+					const PreconditionerType &preconditioner);
+
+	private:
+		/*! mu = E^-1 (AW)^T v */
+		void project(const Vector<double> &v, Vector<double> &mu) const
+		{
+			for (unsigned int i = 0; i < basis.size(); ++i)
+				workspace.AW_v(i) = workspace.AW[i] * v;
+			workspace.E_inv.vmult(mu, workspace.AW_v);
+		}
+		/*! In-place inverse of the symmetric positive definite E by Gauss-Jordan
+		 * elimination without pivoting, which unlike FullMatrix::gauss_jordan()
+		 * needs no buffers */
+		static void invert_spd(FullMatrix<double> &E);
+
+		SolverControl                      &solver_control;
+		const std::vector<Vector<double> > &basis;
+		DeflationWorkspace                 &workspace;
+};
+
+
+
+
+//Definition of the member functions
+//-----------------------------------------------------------
+//-----------------------------------------------------------
+template <typename MatrixType, typename PreconditionerType>
+void SolverDeflatedCG::solve(const MatrixType &A,
+							Vector<double> &x,
+							const Vector<double> &b,
+							const PreconditionerType &preconditioner)
+{
+	const unsigned int k = basis.size();
+	std::vector<Vector<double> > &AW = workspace.AW;
+	FullMatrix<double> &E_inv = workspace.E_inv;
+	Vector<double> &mu = workspace.mu;
+	Vector<double> &Wt_b = workspace.Wt_b;
+	//Vectors of the previous sizes are kept, reinit() only allocates for larger ones
+	if (AW.size() < k)
+		AW.resize(k);
+	E_inv.reinit(k, k);
+	for (unsigned int i = 0; i < k; ++i)
+	{
+		AW[i].reinit(b.size(), true);
+		A.vmult(AW[i], basis[i]);
+		for (unsigned int j = 0; j < k; ++j)
+			E_inv(j, i) = basis[j] * AW[i];
+	}
+	invert_spd(E_inv);
+	workspace.AW_v.reinit(k);
+	mu.reinit(k);
+	Wt_b.reinit(k);
+
+	GrowingVectorMemory<Vector<double> > memory;
+	VectorMemory<Vector<double> >::Pointer r_pointer(memory), z_pointer(memory), p_pointer(memory),
+											q_pointer(memory);
+	Vector<double> &r = *r_pointer, &z = *z_pointer, &p = *p_pointer, &q = *q_pointer;
+	z.reinit(b.size());
+	p.reinit(b.size());
+	q.reinit(b.size());
+
+	//Galerkin initial guess in the deflation space, W^T r = 0
+	r = b;
+	for (unsigned int i = 0; i < k; ++i)
+		Wt_b(i) = basis[i] * b;
+	E_inv.vmult(mu, Wt_b);
+	x = 0.;
+	for (unsigned int i = 0; i < k; ++i)
+	{
+		x.add(mu(i), basis[i]);
+		r.add(-mu(i), AW[i]);
+	}
+
+	preconditioner.vmult(z, r);
+	p = z;
+	project(z, mu);
+	for (unsigned int i = 0; i < k; ++i)
+		p.add(-mu(i), basis[i]);
+	double r_z = r * z;
+
+	unsigned int iteration = 0;
+	SolverControl::State state = solver_control.check(iteration, r.l2_norm());
+	while (state == SolverControl::iterate)
+	{
+		A.vmult(q, p);
+		const double alpha = r_z / (p * q);
+		x.add(alpha, p);
+		r.add(-alpha, q);
+		++iteration;
+		state = solver_control.check(iteration, r.l2_norm());
+		if (state != SolverControl::iterate)
+			break;
+
+		preconditioner.vmult(z, r);
+		const double r_z_new = r * z;
+		const double beta = r_z_new / r_z;
+		r_z = r_z_new;
+		//p = z + beta p - W E^-1 (AW)^T z
+		p.sadd(beta, 1., z);
+		project(z, mu);
+		for (unsigned int i = 0; i < k; ++i)
+			p.add(-mu(i), basis[i]);
+	}
+	AssertThrow(state == SolverControl::success,
+				SolverControl::NoConvergence(solver_control.last_step(), solver_control.last_value()));
+}
+
+
+
+inline
+void SolverDeflatedCG::invert_spd(FullMatrix<double> &E)
+{
+	const unsigned int n = E.m();
+	for (unsigned int p = 0; p < n; ++p)
+	{
+		const double pivot_inverse = 1. / E(p, p);
+		E(p, p) = 1.;
+		for (unsigned int j = 0; j < n; ++j)
+			E(p, j) *= pivot_inverse;
+		for (unsigned int i = 0; i < n; ++i)
+		{
+			if (i == p)
+				continue;
+			const double factor = E(i, p);
+			E(i, p) = 0.;
+			for (unsigned int j = 0; j < n; ++j)
+				E(i, j) -= factor * E(p, j);
+		}
+	}
+}
+//----------------------------------------------------------------------------
+
+#endif
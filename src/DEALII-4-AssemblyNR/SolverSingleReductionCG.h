@@ -0,0 +1,193 @@
+#ifndef SOLVERSINGLEREDUCTIONCG_H
+#define SOLVERSINGLEREDUCTIONCG_H
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/parallel.h>
+#include <deal.II/lac/solver_control.h>
+#include <deal.II/lac/vector.h>
+#include <deal.II/lac/vector_memory.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <vector>
+
+using namespace dealii;
+
+/*! \brief Preconditioned CG with a single global reduction per iteration (Chronopoulos, Gear 1989)
+ *
+ * Plain CG needs the inner product \f$ (\mathbf{p}, \mathbf{A}\mathbf{p}) \f$ before the
+ * update of the residual and \f$ (\mathbf{r}, \mathbf{M}\mathbf{r}) \f$ after it, i.e. two
+ * synchronization points per iteration. Here \f$ \mathbf{w} = \mathbf{A}\mathbf{u} \f$
+ * with \f$ \mathbf{u} = \mathbf{M}\mathbf{r} \f$ is computed instead of \f$ \mathbf{A}\mathbf{p} \f$
+ * and \f$ \mathbf{s} = \mathbf{A}\mathbf{p} \f$ is updated by the recurrence
+ * \f$ \mathbf{s} = \mathbf{w} + \beta \mathbf{s} \f$, such that
+ * \f$ (\mathbf{r},\mathbf{u}) \f$, \f$ (\mathbf{w},\mathbf{u}) \f$ and \f$ (\mathbf{r},\mathbf{r}) \f$
+ * are computed together in one sweep with one reduction. The four vector updates are
+ * fused into one further sweep. Both sweeps run in parallel on fixed chunks of the
+ * vectors, i.e. the sums do not depend on the number of threads.
+ *
+ * The iterates are the same as those of CG in exact arithmetic, the recurrence for
+ * \f$ \mathbf{s} \f$ costs one vector more and is slightly less stable in rounding.
+ * The interface follows the deal.II solvers, convergence is checked by the SolverControl.
+ * The work vectors are taken from a GrowingVectorMemory, i.e. they are reused by the
+ * following solves, and the iterations do not allocate.
+ */
+class SolverSingleReductionCG
+{
+	public:
+		SolverSingleReductionCG(SolverControl &solver_control)
+		:
+		solver_control(solver_control)
+		{}
+
+		template <typename MatrixType, typename PreconditionerType>
+		void solve(const MatrixType &A,
+					Vector<double> &x,
+					const Vector<double> &b,
+					const PreconditionerType &preconditioner);
+
+	private:
+		/*! (r,u), (w,u) and (r,r) in one sweep */
+		std::array<double, 3> fused_inner_products(const Vector<double> &r,
+													const Vector<double> &u,
+													const Vector<double> &w) const;
+		/*! p = u + beta p, s = w + beta s, x += alpha p, r -= alpha s in one sweep */
+		void fused_update(const double alpha,
+						const double beta,
+						const Vector<double> &u,
+						const Vector<double> &w,
+						Vector<double> &p,
+						Vector<double> &s,
+						Vector<double> &x,
+						Vector<double> &r) const;
+
+		SolverControl &solver_control;
+		/*! Number of entries of the chunks the sweeps are split into */
+		static const unsigned int chunk_size = 4096;
+		/*! Sums of the chunks of fused_inner_products(), sized once per solve */
+		mutable std::vector<std::array<double, 3> > partial_sums;
+};
+
+
+
+
+//Definition of the member functions
+//-----------------------------------------------------------
+//-----------------------------------------------------------
+inline
+std::array<double, 3>
+SolverSingleReductionCG::fused_inner_products(const Vector<double> &r,
+											const Vector<double> &u,
+											const Vector<double> &w) const
+{
+	const unsigned int n = r.size();
+	const unsigned int n_chunks = (n + chunk_size - 1) / chunk_size;
+	partial_sums.resize(n_chunks);
+	parallel::apply_to_subranges(0U, n_chunks,
+								[&](const unsigned int chunk_begin, const unsigned int chunk_end)
+								{
+									for (unsigned int chunk = chunk_begin; chunk < chunk_end; ++chunk)
+									{
+										double r_u = 0., w_u = 0., r_r = 0.;
+										const unsigned int end = std::min(n, (chunk + 1) * chunk_size);
+										for (unsigned int i = chunk * chunk_size; i < end; ++i)
+										{
+											r_u += r(i) * u(i);
+											w_u += w(i) * u(i);
+											r_r += r(i) * r(i);
+										}
+										partial_sums[chunk] = {{r_u, w_u, r_r}};
+									}
+								},
+								1);
+	//The only synchronization point of the iteration
+	std::array<double, 3> sums = {{0., 0., 0.}};
+	for (const std::array<double, 3> &partial_sum : partial_sums)
+		for (unsigned int k = 0; k < 3; ++k)
+			sums[k] += partial_sum[k];
+	return sums;
+}
+
+
+
+inline
+void SolverSingleReductionCG::fused_update(const double alpha,
+										const double beta,
+										const Vector<double> &u,
+										const Vector<double> &w,
+										Vector<double> &p,
+										Vector<double> &s,
+										Vector<double> &x,
+										Vector<double> &r) const
+{
+	const unsigned int n = r.size();
+	parallel::apply_to_subranges(0U, n,
+								[&](const unsigned int begin, const unsigned int end)
+								{
+									for (unsigned int i = begin; i < end; ++i)
+									{
+										p(i) = u(i) + beta * p(i);
+										s(i) = w(i) + beta * s(i);
+										x(i) += alpha * p(i);
+										r(i) -= alpha * s(i);
+									}
+								},
+								chunk_size);
+}
+
+
+
+template <typename MatrixType, typename PreconditionerType>
+void SolverSingleReductionCG::solve(const MatrixType &A,
+									Vector<double> &x,
+									const Vector<double> &b,
+									const PreconditionerType &preconditioner)
+{
+	const unsigned int n = b.size();
+	GrowingVectorMemory<Vector<double> > memory;
+	VectorMemory<Vector<double> >::Pointer r_pointer(memory), u_pointer(memory), w_pointer(memory),
+											p_pointer(memory), s_pointer(memory);
+	Vector<double> &r = *r_pointer, &u = *u_pointer, &w = *w_pointer, &p = *p_pointer, &s = *s_pointer;
+	r.reinit(n);
+	u.reinit(n);
+	w.reinit(n);
+	p.reinit(n);
+	s.reinit(n);
+
+	//r = b - A x
+	A.vmult(r, x);
+	r.sadd(-1., 1., b);
+	preconditioner.vmult(u, r);
+	A.vmult(w, u);
+	std::array<double, 3> sums = fused_inner_products(r, u, w);
+
+	unsigned int iteration = 0;
+	SolverControl::State state = solver_control.check(iteration, std::sqrt(sums[2]));
+	double gamma = sums[0];
+	double alpha = gamma / sums[1];
+	double beta = 0.;
+	while (state == SolverControl::iterate)
+	{
+		fused_update(alpha, beta, u, w, p, s, x, r);
+		++iteration;
+
+		preconditioner.vmult(u, r);
+		A.vmult(w, u);
+		sums = fused_inner_products(r, u, w);
+		state = solver_control.check(iteration, std::sqrt(sums[2]));
+		if (state != SolverControl::iterate)
+			break;
+
+		const double gamma_new = sums[0];
+		beta = gamma_new / gamma;
+		//(p, A p) from the recurrences, without an inner product of its own
+		alpha = gamma_new / (sums[1] - beta * gamma_new / alpha);
+		gamma = gamma_new;
+	}
+	AssertThrow(state == SolverControl::success,
+				SolverControl::NoConvergence(solver_control.last_step(), solver_control.last_value()));
+}
+//----------------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,209 @@
+#ifndef SPARSEDIRECTUMFPACKCACHED_H
+#define SPARSEDIRECTUMFPACKCACHED_H
+
+#include <deal.II/base/config.h>
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/timer.h>
+#include <deal.II/lac/sparse_matrix.h>
+#include <deal.II/lac/vector.h>
+
+#ifdef DEAL_II_WITH_UMFPACK
+#include <umfpack.h>
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+using namespace dealii;
+
+/*! \brief Direct solver based on UMFPACK which splits the symbolic and the numeric factorization
+ *
+ * SparseDirectUMFPACK::factorize always runs both the symbolic analysis (ordering,
+ * elimination tree) and the numeric factorization. Within a Newton loop the sparsity
+ * pattern of the tangent never changes, so here the symbolic analysis is done only
+ * at the first call of factorize() after clear() and every further call only
+ * computes a new numeric factorization of the current entries.
+ *
+ * UMFPACK expects the matrix column-wise with sorted indices. The rows of the
+ * SparseMatrix are copied as columns, i.e. the transpose is factorized and solve()
+ * solves with the transpose of the factorization, which gives the solution for the
+ * matrix itself. The mapping of the SparseMatrix entries to the sorted arrays is
+ * computed with the symbolic analysis and reused for every numeric factorization.
+ */
+class SparseDirectUMFPACKCached
+{
+	public:
+		~SparseDirectUMFPACKCached()
+		{
+			clear();
+		}
+		/*! Free the factorizations, the next call of factorize() runs the symbolic analysis again
+		 */
+		void clear()
+		{
+			if (numeric_decomposition != nullptr)
+				umfpack_dl_free_numeric(&numeric_decomposition);
+			if (symbolic_decomposition != nullptr)
+				umfpack_dl_free_symbolic(&symbolic_decomposition);
+			numeric_decomposition = nullptr;
+			symbolic_decomposition = nullptr;
+			Ap.clear();
+			Ai.clear();
+			Ax.clear();
+			permutation.clear();
+		}
+		/*! Numeric factorization of the matrix, preceded by the symbolic analysis if
+		 * none is cached. The sparsity pattern must not change between calls without clear()
+		 */
+		void factorize(const SparseMatrix<double> &matrix);
+		/*! Solve matrix * x = b with the last factorization
+		 */
+		void solve(Vector<double> &x, const Vector<double> &b) const;
+		/*! Same as solve(), such that the class can be used as a preconditioner
+		 */
+		void vmult(Vector<double> &dst, const Vector<double> &src) const
+		{
+			solve(dst, src);
+		}
+		/*! Number of entries of the L and U factors divided by the number of entries of the matrix
+		 */
+		double get_fill_factor() const
+		{
+			return (Ax.empty() ? 0. : double(n_nonzero_factors) / Ax.size());
+		}
+		/*! Wall times of the last symbolic analysis, the last numeric factorization and the last solve
+		 */
+		double get_symbolic_time() const
+		{
+			return symbolic_time;
+		}
+		/*! true if the last factorize() did not need a new symbolic analysis
+		 */
+		bool symbolic_analysis_reused() const
+		{
+			return reused_symbolic;
+		}
+		double get_numeric_time() const
+		{
+			return numeric_time;
+		}
+		double get_solve_time() const
+		{
+			return solve_time;
+		}
+
+	private:
+		void analyze(const SparseMatrix<double> &matrix);
+
+		void *symbolic_decomposition = nullptr;
+		void *numeric_decomposition = nullptr;
+
+		std::vector<SuiteSparse_long> Ap;
+		std::vector<SuiteSparse_long> Ai;
+		std::vector<double>           Ax;
+		/*! Position in Ax of every entry of the SparseMatrix, in its storage order */
+		std::vector<std::size_t>      permutation;
+
+		SuiteSparse_long n_nonzero_factors = 0;
+		bool reused_symbolic = false;
+		double symbolic_time = 0.;
+		double numeric_time = 0.;
+		mutable double solve_time = 0.;
+};
+
+
+
+
+//Definition of the member functions
+//-----------------------------------------------------------
+//-----------------------------------------------------------
+inline
+void SparseDirectUMFPACKCached::analyze(const SparseMatrix<double> &matrix)
+{
+	const SparsityPattern &pattern = matrix.get_sparsity_pattern();
+	const SuiteSparse_long n = matrix.m();
+
+	Ap.resize(n + 1);
+	Ai.resize(matrix.n_nonzero_elements());
+	Ax.resize(matrix.n_nonzero_elements());
+	permutation.resize(matrix.n_nonzero_elements());
+
+	//SparseMatrix stores the diagonal first in every row, UMFPACK needs sorted indices
+	std::size_t index = 0;
+	Ap[0] = 0;
+	for (SuiteSparse_long row = 0; row < n; ++row)
+	{
+		std::vector<std::pair<SuiteSparse_long, std::size_t> > columns;
+		for (auto entry = pattern.begin(row); entry != pattern.end(row); ++entry, ++index)
+			columns.emplace_back(entry->column(), index);
+		std::sort(columns.begin(), columns.end());
+		for (std::size_t k = 0; k < columns.size(); ++k)
+		{
+			Ai[Ap[row] + k] = columns[k].first;
+			permutation[columns[k].second] = Ap[row] + k;
+		}
+		Ap[row + 1] = Ap[row] + columns.size();
+	}
+
+	double control[UMFPACK_CONTROL];
+	umfpack_dl_defaults(control);
+	Timer timer;
+	const int status = umfpack_dl_symbolic(n, n, Ap.data(), Ai.data(), nullptr,
+										&symbolic_decomposition, control, nullptr);
+	AssertThrow(status == UMFPACK_OK, ExcMessage("UMFPACK symbolic analysis failed"));
+	symbolic_time = timer.wall_time();
+}
+
+
+
+inline
+void SparseDirectUMFPACKCached::factorize(const SparseMatrix<double> &matrix)
+{
+	reused_symbolic = (symbolic_decomposition != nullptr);
+	if (!reused_symbolic)
+		analyze(matrix);
+	Assert(matrix.n_nonzero_elements() == Ax.size(),
+			ExcMessage("The sparsity pattern changed since the symbolic analysis"));
+
+	std::size_t index = 0;
+	for (auto entry = matrix.begin(); entry != matrix.end(); ++entry, ++index)
+		Ax[permutation[index]] = entry->value();
+
+	if (numeric_decomposition != nullptr)
+		umfpack_dl_free_numeric(&numeric_decomposition);
+	double control[UMFPACK_CONTROL];
+	umfpack_dl_defaults(control);
+	Timer timer;
+	const int status = umfpack_dl_numeric(Ap.data(), Ai.data(), Ax.data(), symbolic_decomposition,
+										&numeric_decomposition, control, nullptr);
+	AssertThrow(status == UMFPACK_OK, ExcMessage("UMFPACK numeric factorization failed"));
+	numeric_time = timer.wall_time();
+
+	SuiteSparse_long n_nonzero_L, n_nonzero_U, n_row, n_col, n_nonzero_diagonal_U;
+	umfpack_dl_get_lunz(&n_nonzero_L, &n_nonzero_U, &n_row, &n_col, &n_nonzero_diagonal_U,
+						numeric_decomposition);
+	n_nonzero_factors = n_nonzero_L + n_nonzero_U;
+}
+
+
+
+inline
+void SparseDirectUMFPACKCached::solve(Vector<double> &x, const Vector<double> &b) const
+{
+	Assert(numeric_decomposition != nullptr, ExcMessage("factorize() has to be called first"));
+	Assert(&x != &b, ExcMessage("Source and destination must not be the same vector"));
+	double control[UMFPACK_CONTROL];
+	umfpack_dl_defaults(control);
+	Timer timer;
+	//The arrays hold the transpose of the matrix, see the class documentation
+	const int status = umfpack_dl_solve(UMFPACK_At, Ap.data(), Ai.data(), Ax.data(),
+										x.begin(), b.begin(), numeric_decomposition,
+										control, nullptr);
+	AssertThrow(status == UMFPACK_OK, ExcMessage("UMFPACK solve failed"));
+	solve_time = timer.wall_time();
+}
+//----------------------------------------------------------------------------
+
+#endif // DEAL_II_WITH_UMFPACK
+
+#endif
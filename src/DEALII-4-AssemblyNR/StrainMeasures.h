@@ -5,8 +5,10 @@
 #include <deal.II/lac/vector.h>
 #include <deal.II/base/tensor.h>
 #include <deal.II/base/symmetric_tensor.h>
+#include <deal.II/base/vectorization.h>
 #include <deal.II/physics/elasticity/standard_tensors.h>
 #include <iostream>
+#include <stdexcept>
 
 using namespace dealii;
 
@@ -20,6 +22,9 @@ using namespace dealii;
  * as input. Standard unit tensors are used from the header file
  * deal.II/physics/elasticity/standard_tensors.h.
  *
+ * The functions are templated on the number type, i.e. they also work with
+ * VectorizedArray<double>, which evaluates several deformation gradients at once.
+ *
 */
 
 /* A namespace that groups functions to compute several strain measures, 
@@ -33,19 +38,31 @@ namespace StrainMeasures
 //-----------------------------------------------------------
 //-----------------------------------------------------------
 
+	/*!A scalar of the given number type with the given value, i.e. the value in all
+	 * lanes of a VectorizedArray
+	 */
+	template <typename Number>
+	Number make_number(const double value)
+	{
+		Number number;
+		number = value;
+		return number;
+	}
+	//------------------------------------------
+
 	/*!Compute the right CauchyGreen strain tensor as
 	 * \f$ \mathbf{C} =  \mathbf{F}^T \cdot \mathbf{F} \f$
 	 * @param F Deformation gradient
 	 */
-	template <int dim>
-	SymmetricTensor<2, dim> get_RightCauchyGreenTensor(const Tensor<2, dim> &F)
+	template <int dim, typename Number>
+	SymmetricTensor<2, dim, Number> get_RightCauchyGreenTensor(const Tensor<2, dim, Number> &F)
 	{
 		/* Compute the right CauchyGreen tensor
 		* using the member variable "F" and the deal.II function
 		* "transpose(). Hint: in order to get a symmetric tensor 
 		* use the function "symmetrize()"!
 		*/
-		SymmetricTensor<2,dim> RightCauchyGreenTensor;
+		SymmetricTensor<2,dim,Number> RightCauchyGreenTensor;
 		
 		//BEGIN - INSERT YOUR CODE HERE
 		RightCauchyGreenTensor = symmetrize( transpose(F) * F);
@@ -60,15 +77,15 @@ namespace StrainMeasures
 	 * \f$ \mathbf{b} =  \mathbf{F} \cdot \mathbf{F}^T \f$
 	 * @param F Deformation gradient
 	 */
-	template <int dim>
-	SymmetricTensor<2, dim> get_LeftCauchyGreenTensor(const Tensor<2, dim> &F) 
+	template <int dim, typename Number>
+	SymmetricTensor<2, dim, Number> get_LeftCauchyGreenTensor(const Tensor<2, dim, Number> &F)
 	{
 		/* Compute the left CauchyGreen tensor
 		* using the member variable "F" and the deal.II function
 		* "transpose(). Hint: in order to get a symmetric tensor 
 		* use the function "symmetrize()"!
 		*/
-		SymmetricTensor<2,dim> LeftCauchyGreenTensor;
+		SymmetricTensor<2,dim,Number> LeftCauchyGreenTensor;
 		
 		//BEGIN - INSERT YOUR CODE HERE
 		LeftCauchyGreenTensor = symmetrize(F * transpose(F));
@@ -84,17 +101,17 @@ namespace StrainMeasures
 	 * \f$ \mathbf{E} =  \frac{1}{2} \left[ \mathbf{C} - \mathbf{I} \right] \f$
 	 * @param F Deformation gradient
 	 */
-	template <int dim>
-	SymmetricTensor<2, dim> get_GreenLagrangeTensor(const Tensor<2, dim> &F) 
+	template <int dim, typename Number>
+	SymmetricTensor<2, dim, Number> get_GreenLagrangeTensor(const Tensor<2, dim, Number> &F)
 	{
 		/* Compute the Green tensor
 		* using the previously definted function 
 		* "get_RightCauchyGreenTensor" and "Physics::Elasticity::StandardTensors<dim>::I"
 		*/
-		SymmetricTensor<2,dim> GreenLagrangeTensor;
+		SymmetricTensor<2,dim,Number> GreenLagrangeTensor;
 		
 		//BEGIN - INSERT YOUR CODE HERE
-		GreenLagrangeTensor = (0.5 * (get_RightCauchyGreenTensor(F) - Physics::Elasticity::StandardTensors<dim>::I ) );
+		GreenLagrangeTensor = (make_number<Number>(0.5) * (get_RightCauchyGreenTensor(F) - unit_symmetric_tensor<dim,Number>() ) );
 		
 		
 		//END - INSERT YOUR CODE HERE	
@@ -107,17 +124,17 @@ namespace StrainMeasures
 	 * \f$ \mathbf{e} =  \frac{1}{2} \left[ \mathbf{I} - \mathbf{b}^{-1} \right] \f$
 	 * @param F Deformation gradient
 	 */
-	template <int dim>
-	SymmetricTensor<2, dim> get_AlmansiTensor(const Tensor<2, dim> &F) 
+	template <int dim, typename Number>
+	SymmetricTensor<2, dim, Number> get_AlmansiTensor(const Tensor<2, dim, Number> &F)
 	{
 		/* Compute the Almansi strain tensor
 		* using the previously definted function 
 		* "get_LeftCauchyGreenTensor", "Physics::Elasticity::StandardTensors<dim>::I" and the 
 		* deal.II function "invert()" for the tensor LCG
 		*/
-		SymmetricTensor<2,dim> AlmansiTensor;
+		SymmetricTensor<2,dim,Number> AlmansiTensor;
 		//BEGIN - INSERT YOUR CODE HERE
-		AlmansiTensor = (0.5 * (Physics::Elasticity::StandardTensors<dim>::I - invert(get_LeftCauchyGreenTensor(F) ) ));
+		AlmansiTensor = (make_number<Number>(0.5) * (unit_symmetric_tensor<dim,Number>() - invert(get_LeftCauchyGreenTensor(F) ) ));
 		
 		
 		//END - INSERT YOUR CODE HERE	
@@ -126,6 +143,18 @@ namespace StrainMeasures
 	}
 	//------------------------------------------
 
+    //------------------------------------------
+    /*! Thrown for a deformation gradient with \f$ J \leq 0 \f$, i.e. a state the
+    * load stepping can recover from by a smaller load increment
+    */
+    class InvalidDeformation : public std::runtime_error
+    {
+        public:
+            InvalidDeformation()
+            :
+            std::runtime_error("det_F !> 0")
+            {}
+    };
     //------------------------------------------
     /*! A function to compute and return the determinant
     * of the deformation gradient \f$ J =
@@ -139,10 +168,73 @@ namespace StrainMeasures
         if(det_F <= 0)
         {
             std::cout<<"F:\n"<<F<<std::endl;
-            throw std::runtime_error("det_F !> 0");
+            throw InvalidDeformation();
         }
         return det_F;
     }
+    //------------------------------------------
+    /*! Same as above, with the interface of the vectorized variant: a
+    * non-positive determinant still throws, i.e. invalid_lanes is always zero
+    */
+    template <int dim>
+    double get_DeterminantDefoGrad(const Tensor<2, dim> &F, unsigned int &invalid_lanes)
+    {
+        invalid_lanes = 0;
+        return get_DeterminantDefoGrad(F);
+    }
+    //------------------------------------------
+    /*! Lane-wise determinant of several deformation gradients at once. Instead of
+    * throwing, bit l of invalid_lanes is set if \f$ J \leq 0 \f$ in lane l, and J of
+    * this lane is replaced by 1 such that \f$ \text{ln}\left( J \right) \f$ stays
+    * finite. F itself is not changed, i.e. quantities like its inverse need F = I in
+    * these lanes, see get_DefoGradWithIdentityInLanes(). The caller decides how to
+    * treat the invalid lanes, e.g. ignore the empty lanes of the last batch
+    * @return \f$ J = \text{det}\left( \mathbf{F} \right) \f$ in every lane
+    */
+    template <int dim, typename Number>
+    VectorizedArray<Number> get_DeterminantDefoGrad(const Tensor<2, dim, VectorizedArray<Number> > &F,
+                                                    unsigned int &invalid_lanes)
+    {
+        VectorizedArray<Number> det_F = determinant(F);
+        invalid_lanes = 0;
+        for (unsigned int l = 0; l < VectorizedArray<Number>::n_array_elements; ++l)
+        {
+            if (!(det_F[l] > 0))
+            {
+                invalid_lanes |= (1U << l);
+                det_F[l] = 1;
+            }
+        }
+        return det_F;
+    }
+    //------------------------------------------
+    /*! Same as below for a single deformation gradient, where no lane can be invalid
+    */
+    template <int dim>
+    Tensor<2, dim> get_DefoGradWithIdentityInLanes(const Tensor<2, dim> &F, const unsigned int)
+    {
+        return F;
+    }
+    //------------------------------------------
+    /*! Copy of F with the identity in every lane whose bit is set in lanes, e.g. the
+    * invalid_lanes of get_DeterminantDefoGrad()
+    */
+    template <int dim, typename Number>
+    Tensor<2, dim, VectorizedArray<Number> > get_DefoGradWithIdentityInLanes(const Tensor<2, dim, VectorizedArray<Number> > &F,
+                                                                            const unsigned int lanes)
+    {
+        Tensor<2, dim, VectorizedArray<Number> > F_lanes = F;
+        for (unsigned int l = 0; l < VectorizedArray<Number>::n_array_elements; ++l)
+        {
+            if ((lanes >> l) & 1U)
+            {
+                for (unsigned int i = 0; i < dim; ++i)
+                    for (unsigned int j = 0; j < dim; ++j)
+                        F_lanes[i][j][l] = (i == j ? 1. : 0.);
+            }
+        }
+        return F_lanes;
+    }
 }
 
 
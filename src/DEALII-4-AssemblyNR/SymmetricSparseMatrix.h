@@ -0,0 +1,243 @@
+#ifndef SYMMETRICSPARSEMATRIX_H
+#define SYMMETRICSPARSEMATRIX_H
+
+#include <deal.II/base/exceptions.h>
+#include <deal.II/base/memory_consumption.h>
+#include <deal.II/base/subscriptor.h>
+#include <deal.II/base/types.h>
+//The library instantiates AffineConstraints::distribute_local_to_global only for its
+//own matrix types, the generic definition is needed for this one
+#include <deal.II/lac/affine_constraints.templates.h>
+#include <deal.II/lac/dynamic_sparsity_pattern.h>
+#include <deal.II/lac/exceptions.h>
+#include <deal.II/lac/vector.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace dealii;
+
+/*! \brief Sparse matrix storing only the upper triangle of a symmetric matrix
+ *
+ * The entries are kept row-wise (CSR) for all columns \f$ j \geq i \f$, with the
+ * diagonal element first in every row and the remaining columns sorted. Entries
+ * below the diagonal that are added, e.g. by AffineConstraints::distribute_local_to_global,
+ * are ignored since they are represented by their symmetric counterpart.
+ *
+ * vmult() runs over the upper triangle once and applies each off-diagonal entry
+ * to both triangles. precondition_SSOR() provides the interface PreconditionSSOR
+ * uses, such that the matrix can be used with SolverCG and PreconditionSSOR
+ * like a SparseMatrix.
+ */
+class SymmetricSparseMatrix : public Subscriptor
+{
+	public:
+		typedef double                  value_type;
+		typedef types::global_dof_index size_type;
+
+		/*! Allocate the upper triangle of the given (full) sparsity pattern
+		 */
+		void reinit(const DynamicSparsityPattern &dsp);
+		/*! Only zero may be assigned, i.e. reset all entries
+		 */
+		SymmetricSparseMatrix &operator=(const double d);
+		/*! Add value to entry (i,j); ignored if j < i
+		 */
+		void add(const size_type i, const size_type j, const double value);
+		/*! Add a row of values; entries left of the diagonal are ignored.
+		 * Same signature as SparseMatrix::add such that AffineConstraints can
+		 * write into this matrix
+		 */
+		void add(const size_type row,
+				const size_type n_cols,
+				const size_type *col_indices,
+				const double *vals,
+				const bool elide_zero_values = true,
+				const bool col_indices_are_sorted = false);
+		/*! dst = A * src
+		 */
+		void vmult(Vector<double> &dst, const Vector<double> &src) const;
+		/*! The matrix is symmetric, i.e. Tvmult equals vmult
+		 */
+		void Tvmult(Vector<double> &dst, const Vector<double> &src) const
+		{
+			vmult(dst, src);
+		}
+		/*! Apply the SSOR preconditioner with relaxation parameter omega.
+		 * The last argument is only there for compatibility with PreconditionSSOR,
+		 * the diagonal is always the first entry of a row
+		 */
+		void precondition_SSOR(Vector<double> &dst,
+							const Vector<double> &src,
+							const double omega = 1.,
+							const std::vector<std::size_t> &pos_right_of_diagonal = std::vector<std::size_t>()) const;
+
+		double diag_element(const size_type i) const
+		{
+			return values[row_start[i]];
+		}
+		size_type m() const
+		{
+			return row_start.empty() ? 0 : row_start.size() - 1;
+		}
+		size_type n() const
+		{
+			return m();
+		}
+		/*! Number of stored entries, i.e. of the upper triangle including the diagonal
+		 */
+		std::size_t n_nonzero_elements() const
+		{
+			return values.size();
+		}
+		std::size_t memory_consumption() const
+		{
+			return (MemoryConsumption::memory_consumption(row_start)
+					+ MemoryConsumption::memory_consumption(column_indices)
+					+ MemoryConsumption::memory_consumption(values));
+		}
+
+	private:
+		std::vector<std::size_t> row_start;
+		std::vector<size_type>   column_indices;
+		std::vector<double>      values;
+};
+
+
+
+
+//Definition of the member functions
+//-----------------------------------------------------------
+//-----------------------------------------------------------
+inline
+void SymmetricSparseMatrix::reinit(const DynamicSparsityPattern &dsp)
+{
+	Assert(dsp.n_rows() == dsp.n_cols(), ExcNotQuadratic());
+	const size_type n_rows = dsp.n_rows();
+
+	row_start.assign(n_rows + 1, 0);
+	for (size_type i = 0; i < n_rows; ++i)
+	{
+		//The diagonal is stored in any case
+		std::size_t row_length = 1;
+		for (size_type k = 0; k < dsp.row_length(i); ++k)
+			if (dsp.column_number(i, k) > i)
+				++row_length;
+		row_start[i + 1] = row_start[i] + row_length;
+	}
+
+	column_indices.resize(row_start[n_rows]);
+	values.assign(row_start[n_rows], 0.);
+	for (size_type i = 0; i < n_rows; ++i)
+	{
+		std::size_t index = row_start[i];
+		column_indices[index++] = i;
+		//The columns of a DynamicSparsityPattern are sorted
+		for (size_type k = 0; k < dsp.row_length(i); ++k)
+			if (dsp.column_number(i, k) > i)
+				column_indices[index++] = dsp.column_number(i, k);
+	}
+}
+
+
+
+inline
+SymmetricSparseMatrix &SymmetricSparseMatrix::operator=(const double d)
+{
+	Assert(d == 0, ExcScalarAssignmentOnlyForZeroValue());
+	(void)d;
+	std::fill(values.begin(), values.end(), 0.);
+	return *this;
+}
+
+
+
+inline
+void SymmetricSparseMatrix::add(const size_type i, const size_type j, const double value)
+{
+	if (j < i)
+		return;
+	if (j == i)
+	{
+		values[row_start[i]] += value;
+		return;
+	}
+	const auto begin = column_indices.begin() + row_start[i] + 1;
+	const auto end = column_indices.begin() + row_start[i + 1];
+	const auto position = std::lower_bound(begin, end, j);
+	Assert(position != end && *position == j,
+			ExcMessage("Entry does not exist in the sparsity pattern"));
+	values[position - column_indices.begin()] += value;
+}
+
+
+
+inline
+void SymmetricSparseMatrix::add(const size_type row,
+								const size_type n_cols,
+								const size_type *col_indices,
+								const double *vals,
+								const bool elide_zero_values,
+								const bool /*col_indices_are_sorted*/)
+{
+	for (size_type k = 0; k < n_cols; ++k)
+	{
+		if (elide_zero_values && vals[k] == 0.)
+			continue;
+		add(row, col_indices[k], vals[k]);
+	}
+}
+
+
+
+inline
+void SymmetricSparseMatrix::vmult(Vector<double> &dst, const Vector<double> &src) const
+{
+	Assert(&dst != &src, ExcMessage("Source and destination must not be the same vector"));
+	dst = 0.;
+	for (size_type i = 0; i < m(); ++i)
+	{
+		const double src_i = src(i);
+		double dst_i = values[row_start[i]] * src_i;
+		for (std::size_t k = row_start[i] + 1; k < row_start[i + 1]; ++k)
+		{
+			const size_type j = column_indices[k];
+			//Upper entry (i,j) and its mirrored lower entry (j,i)
+			dst_i += values[k] * src(j);
+			dst(j) += values[k] * src_i;
+		}
+		dst(i) += dst_i;
+	}
+}
+
+
+
+inline
+void SymmetricSparseMatrix::precondition_SSOR(Vector<double> &dst,
+											const Vector<double> &src,
+											const double omega,
+											const std::vector<std::size_t> &) const
+{
+	dst = src;
+	//Forward sweep with the lower triangle, i.e. column-wise through the stored upper one
+	for (size_type i = 0; i < m(); ++i)
+	{
+		dst(i) *= omega / values[row_start[i]];
+		for (std::size_t k = row_start[i] + 1; k < row_start[i + 1]; ++k)
+			dst(column_indices[k]) -= values[k] * dst(i);
+	}
+	//Scaling with the diagonal
+	for (size_type i = 0; i < m(); ++i)
+		dst(i) *= (2. - omega) / omega * values[row_start[i]] / omega;
+	//Backward sweep with the upper triangle
+	for (size_type i = m(); i-- > 0;)
+	{
+		double s = dst(i);
+		for (std::size_t k = row_start[i] + 1; k < row_start[i + 1]; ++k)
+			s -= values[k] * dst(column_indices[k]);
+		dst(i) = s * omega / values[row_start[i]];
+	}
+}
+//----------------------------------------------------------------------------
+
+#endif